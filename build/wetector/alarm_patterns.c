@@ -0,0 +1,92 @@
+#include <avr/pgmspace.h>
+
+#include "wetector/alarm_patterns.h"
+
+
+
+const struct alarm_step alarm_steps[] PROGMEM = {
+
+  { 41, 0x3C }, { 41, 0x3C }, { 41, 0x3C }, { 42, 0x3A }, { 42, 0x3A }, { 42, 0x3A },
+
+  { 43, 0x39 }, { 43, 0x39 }, { 44, 0x38 }, { 44, 0x38 }, { 44, 0x38 }, { 45, 0x36 },
+
+  { 45, 0x36 }, { 46, 0x35 }, { 46, 0x35 }, { 47, 0x34 }, { 47, 0x34 }, { 48, 0x33 },
+
+  { 48, 0x33 }, { 49, 0x32 }, { 49, 0x32 }, { 50, 0x31 }, { 50, 0x31 }, { 51, 0x30 },
+
+  { 51, 0x30 }, { 52, 0x2F }, { 52, 0x2F }, { 53, 0x2E }, { 53, 0x2E }, { 54, 0x2D },
+
+  { 55, 0x2D }, { 55, 0x2D }, { 56, 0x2C }, { 56, 0x2C }, { 57, 0x2B }, { 58, 0x2A },
+
+  { 59, 0x2A }, { 59, 0x2A }, { 60, 0x29 }, { 61, 0x28 }, { 62, 0x28 }, { 62, 0x28 },
+
+  { 63, 0x27 }, { 64, 0x26 }, { 65, 0x26 }, { 66, 0x25 }, { 67, 0x25 }, { 67, 0x25 },
+
+  { 68, 0x24 }, { 69, 0x24 }, { 70, 0x23 }, { 71, 0x23 }, { 73, 0x22 }, { 74, 0x21 },
+
+  { 75, 0x21 }, { 76, 0x20 }, { 77, 0x20 }, { 78, 0x20 }, { 80, 0x1F }, { 81, 0x1E },
+
+  { 82, 0x1E }, { 84, 0x1D }, { 85, 0x1D }, { 87, 0x1C }, { 88, 0x1C }, { 90, 0x1B },
+
+  { 92, 0x1B }, { 93, 0x1B }, { 95, 0x1A }, { 97, 0x1A }, { 99, 0x19 }, { 101, 0x19 },
+
+  { 103, 0x18 }, { 105, 0x18 }, { 108, 0x17 }, { 110, 0x17 }, { 113, 0x16 }, { 115, 0x16 },
+
+  { 118, 0x15 }, { 121, 0x14 }, { 124, 0x14 }, { 121, 0x14 }, { 118, 0x15 }, { 115, 0x16 },
+
+  { 113, 0x16 }, { 110, 0x17 }, { 108, 0x17 }, { 105, 0x18 }, { 103, 0x18 }, { 101, 0x19 },
+
+  { 99, 0x19 }, { 97, 0x1A }, { 95, 0x1A }, { 93, 0x1B }, { 92, 0x1B }, { 90, 0x1B },
+
+  { 88, 0x1C }, { 87, 0x1C }, { 85, 0x1D }, { 84, 0x1D }, { 82, 0x1E }, { 81, 0x1E },
+
+  { 80, 0x1F }, { 78, 0x20 }, { 77, 0x20 }, { 76, 0x20 }, { 75, 0x21 }, { 74, 0x21 },
+
+  { 73, 0x22 }, { 71, 0x23 }, { 70, 0x23 }, { 69, 0x24 }, { 68, 0x24 }, { 67, 0x25 },
+
+  { 67, 0x25 }, { 66, 0x25 }, { 65, 0x26 }, { 64, 0x26 }, { 63, 0x27 }, { 62, 0x28 },
+
+  { 62, 0x28 }, { 61, 0x28 }, { 60, 0x29 }, { 59, 0x2A }, { 59, 0x2A }, { 58, 0x2A },
+
+  { 57, 0x2B }, { 56, 0x2C }, { 56, 0x2C }, { 55, 0x2D }, { 55, 0x2D }, { 54, 0x2D },
+
+  { 53, 0x2E }, { 53, 0x2E }, { 52, 0x2F }, { 52, 0x2F }, { 51, 0x30 }, { 51, 0x30 },
+
+  { 50, 0x31 }, { 50, 0x31 }, { 49, 0x32 }, { 49, 0x32 }, { 48, 0x33 }, { 48, 0x33 },
+
+  { 47, 0x34 }, { 47, 0x34 }, { 46, 0x35 }, { 46, 0x35 }, { 45, 0x36 }, { 45, 0x36 },
+
+  { 44, 0x38 }, { 44, 0x38 }, { 44, 0x38 }, { 43, 0x39 }, { 43, 0x39 }, { 42, 0x3A },
+
+  { 42, 0x3A }, { 42, 0x3A }, { 41, 0x3C }, { 41, 0x3C }, { 49, 0x32 }, { 49, 0x32 },
+
+  { 49, 0x32 }, { 49, 0x32 }, { 49, 0x32 }, { 49, 0x32 }, { 49, 0x32 }, { 49, 0x32 },
+
+  { 49, 0x32 }, { 49, 0x32 }, { 49, 0x32 }, { 49, 0x32 }, { 49, 0x32 }, { 49, 0x32 },
+
+  { 49, 0x32 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 },
+
+  { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 },
+
+  { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 82, 0x1E }, { 70, 0x23 },
+
+  { 62, 0x28 }, { 55, 0x2D }, { 49, 0x32 }, { 44, 0x38 }, { 41, 0x3C }, { 37, 0x42 },
+
+  { 35, 0x45 }, { 32, 0x4C }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 },
+
+  { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 },
+
+  { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 },
+
+  { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 },
+
+  { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 },
+
+  { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 },
+
+  { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 }, { 124, 0x94 },
+
+};
+
+// Index of each pattern's first step, plus one past the last pattern
+const uint16_t alarm_pattern_starts[] PROGMEM = { 0, 160, 190, 240 };
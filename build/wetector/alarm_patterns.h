@@ -0,0 +1,36 @@
+#ifndef ALARM_PATTERNS_H
+#define ALARM_PATTERNS_H
+
+#include <inttypes.h>
+#include <avr/pgmspace.h>
+
+
+
+// The tables assume Timer2 at /64 from a 16 MHz clock
+#define ALARM_PATTERN_F_CPU 16000000UL
+
+// One step of a pattern: the OCR2A value of its tone and how many
+// compare matches it lasts, with ALARM_STEP_SILENT set for a rest
+#define ALARM_STEP_SILENT 0x80
+
+struct alarm_step {
+  uint8_t ocr;
+  uint8_t matches;
+};
+
+
+#define ALARM_PATTERN_SIREN 0
+
+
+#define ALARM_PATTERN_BEEP 1
+
+
+#define ALARM_PATTERN_CHIRP 2
+
+
+#define ALARM_PATTERN_COUNT 3
+
+extern const struct alarm_step alarm_steps[] PROGMEM;
+extern const uint16_t alarm_pattern_starts[] PROGMEM;
+
+#endif
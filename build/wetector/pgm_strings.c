@@ -0,0 +1,32 @@
+#include <avr/pgmspace.h>
+
+#include "wetector/pgm_strings.h"
+
+
+
+const char wt_pgm_str_wetector_shell_stats_header[] PROGMEM = "\n\t20s\t10m\n";
+
+const char wt_pgm_str_wetector_shell_stats_row[] PROGMEM = "%s\t%u.%u\t%u.%u\n";
+
+const char wt_pgm_str_wetector_shell_samples_20_sec[] PROGMEM = "%s 20s:\n";
+
+const char wt_pgm_str_wetector_shell_samples_10_min[] PROGMEM = "%s 10m:\n";
+
+const char wt_pgm_str_wetector_shell_samples_raw[] PROGMEM = "%s raw:\n";
+
+const char wt_pgm_str_wetector_shell_dht11_last[] PROGMEM = "res\t%u\tbits\t%u\n";
+
+const char wt_pgm_str_wetector_shell_dht11_pulses[] PROGMEM = "pulse\t%u\t%u\tthr\t%u\n";
+
+const char wt_pgm_str_wetector_shell_dht11_results[] PROGMEM = "ok\t%u\tst1\t%u\tst2\t%u\tcks\t%u\ttmo\t%u\n";
+
+const char wt_pgm_str_wetector_shell_profile_header[] PROGMEM = "tick\t%uus\ntask\truns\tticks\tmax\tlate\tlmax\n";
+
+const char wt_pgm_str_wetector_shell_profile_row[] PROGMEM = "%s\t%lu\t%lu\t%u\t%u\t%u\n";
+
+const char wt_pgm_str_wetector_shell_rollup_header[] PROGMEM = "\n%c\tperiod\tch\tmin\tmax\tavg\n";
+
+const char wt_pgm_str_wetector_shell_rollup_row[] PROGMEM = "%u\t%u\t%s\t%u\t%u\t%u\n";
+
+const char wt_pgm_str_wetector_shell_power[] PROGMEM = "sleeps\t%lu\tasleep\t%lums\tawake\t%lums\t%u.%u%%\n\n";
+
@@ -0,0 +1,67 @@
+#ifndef PGM_STRINGS_H
+#define PGM_STRINGS_H
+
+#include <avr/pgmspace.h>
+
+
+
+// Strings stay in flash and go straight to print_format_P or fputs_P,
+// e.g. print_format_P(stream, WT_PGM_WETECTOR_SHELL_STATS_ROW, ...)
+
+
+#define WT_PGM_WETECTOR_SHELL_STATS_HEADER wt_pgm_str_wetector_shell_stats_header
+
+#define WT_PGM_WETECTOR_SHELL_STATS_ROW wt_pgm_str_wetector_shell_stats_row
+
+#define WT_PGM_WETECTOR_SHELL_SAMPLES_20_SEC wt_pgm_str_wetector_shell_samples_20_sec
+
+#define WT_PGM_WETECTOR_SHELL_SAMPLES_10_MIN wt_pgm_str_wetector_shell_samples_10_min
+
+#define WT_PGM_WETECTOR_SHELL_SAMPLES_RAW wt_pgm_str_wetector_shell_samples_raw
+
+#define WT_PGM_WETECTOR_SHELL_DHT11_LAST wt_pgm_str_wetector_shell_dht11_last
+
+#define WT_PGM_WETECTOR_SHELL_DHT11_PULSES wt_pgm_str_wetector_shell_dht11_pulses
+
+#define WT_PGM_WETECTOR_SHELL_DHT11_RESULTS wt_pgm_str_wetector_shell_dht11_results
+
+#define WT_PGM_WETECTOR_SHELL_PROFILE_HEADER wt_pgm_str_wetector_shell_profile_header
+
+#define WT_PGM_WETECTOR_SHELL_PROFILE_ROW wt_pgm_str_wetector_shell_profile_row
+
+#define WT_PGM_WETECTOR_SHELL_ROLLUP_HEADER wt_pgm_str_wetector_shell_rollup_header
+
+#define WT_PGM_WETECTOR_SHELL_ROLLUP_ROW wt_pgm_str_wetector_shell_rollup_row
+
+#define WT_PGM_WETECTOR_SHELL_POWER wt_pgm_str_wetector_shell_power
+
+
+
+extern const char wt_pgm_str_wetector_shell_stats_header[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_stats_row[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_samples_20_sec[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_samples_10_min[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_samples_raw[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_dht11_last[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_dht11_pulses[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_dht11_results[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_profile_header[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_profile_row[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_rollup_header[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_rollup_row[] PROGMEM;
+
+extern const char wt_pgm_str_wetector_shell_power[] PROGMEM;
+
+
+#endif
@@ -0,0 +1,312 @@
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+
+#include "avr_mcu_section.h"
+
+#include "common.h"
+#include "dht11.h"
+#include "eeprom_writer.h"
+#include "hal/hal.h"
+#include "hum_temp.h"
+#include "sample_buffer.h"
+#include "sample_log.h"
+
+// Benchmarks the firmware hot paths under simavr. Timer1 runs at the
+// CPU clock with an overflow count on top, so every figure is in CPU
+// cycles, with the cost of reading the counter taken off. Stack depth
+// is measured by painting the free RAM below the stack before a
+// benchmark and finding the deepest byte it overwrote.
+//
+// Results go out through the simavr console register as
+//   bench,<name>,<runs>,<mean cycles>,<max cycles>,<stack bytes>
+// and the simulator exits when the CPU sleeps with interrupts off.
+
+AVR_MCU(F_CPU, "atmega328p");
+AVR_MCU_SIMAVR_CONSOLE(&GPIOR0);
+
+#define STACK_PAINT 0xC5
+#define RUNS 64
+
+#define BENCH(NAME, BENCH_RUNS, CALL) do { \
+  uint16_t stack_top = SP; \
+  paint_stack(); \
+  uint32_t total = 0; \
+  uint32_t max = 0; \
+  for (uint16_t run = 0; run < (BENCH_RUNS); run++) { \
+    uint32_t start = cycles(); \
+    CALL; \
+    uint32_t elapsed = cycles() - start - cycles_overhead; \
+    total += elapsed; \
+    if (elapsed > max) max = elapsed; \
+  } \
+  report(PSTR(NAME), (BENCH_RUNS), total / (BENCH_RUNS), max, stack_top - stack_low_water()); \
+} while (0)
+
+SAMPLE_BUFFER_DEFINE(10)
+BUCKET_BUFFER_DEFINE(30, 10)
+// The bytes of a 300 sample sample_buffer
+DELTA_BUFFER_DEFINE(338)
+
+// The ring as it was before push_sample wrapped without division, kept
+// as the reference its rows are compared against
+struct modulo_buffer {
+  uint16_t size;
+  uint16_t start;
+  uint16_t count;
+  uint32_t sum;
+  uint8_t* samples;
+};
+
+extern uint8_t __heap_start;
+
+static volatile uint16_t overflows;
+static uint32_t cycles_overhead;
+
+static struct sample_buffer_10 samples;
+static struct bucket_buffer_30 buckets;
+static struct delta_buffer_338 history;
+static uint8_t modulo_samples[10];
+static struct modulo_buffer modulo = { .size = sizeof(modulo_samples), .samples = modulo_samples };
+static const struct gpio sensor_gpio = { .port = GPIO_PORT_C, .pin = GPIO_PIN_0 };
+
+static int console_put(char c, FILE* stream);
+static int null_put(char c, FILE* stream);
+
+static FILE console = FDEV_SETUP_STREAM(console_put, NULL, _FDEV_SETUP_WRITE);
+static FILE null_stream = FDEV_SETUP_STREAM(null_put, NULL, _FDEV_SETUP_WRITE);
+
+static uint32_t cycles(void);
+static void paint_stack(void) __attribute__((noinline));
+static uint16_t stack_low_water(void);
+static void report(PGM_P name, uint16_t runs, uint32_t mean, uint32_t max, uint16_t stack);
+
+static void bench_sample_buffer(void);
+static void bench_hum_temp(void);
+static void bench_dht11(void);
+static void bench_sample_log(void);
+
+static void modulo_push_sample(struct modulo_buffer* buffer, const uint8_t sample) __attribute__((noinline, noclone));
+static void fill_samples(void);
+static uint32_t edge(uint8_t high);
+static void wait_us(uint8_t us);
+
+int main(void) {
+  stdout = &console;
+
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+  TIMSK1 = _BV(TOIE1);
+  // The DHT11 decoder timestamps edges with Timer0
+  TCCR0A = 0;
+  TCCR0B = _BV(CS01) | _BV(CS00);
+  sei();
+
+  uint32_t start = cycles();
+  cycles_overhead = cycles() - start;
+
+  bench_sample_buffer();
+  bench_hum_temp();
+  bench_dht11();
+  bench_sample_log();
+
+  cli();
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  sleep_cpu();
+  return 0;
+}
+
+static void bench_sample_buffer(void) {
+  sample_buffer_10_init(&samples);
+  bucket_buffer_30_init(&buckets);
+
+  uint8_t sample = 40;
+  BENCH("push_sample_modulo", RUNS, modulo_push_sample(&modulo, sample++));
+  BENCH("push_sample", RUNS, push_sample(&samples.super, sample++));
+  BENCH("sample_buffer_10_push", RUNS, sample_buffer_10_push(&samples, sample++));
+  BENCH("sample_buffer_10_push_invalid", RUNS, sample_buffer_10_push_invalid(&samples));
+
+  // Ten pushes per window, so every tenth roll does the work
+  fill_samples();
+  BENCH("bucket_buffer_30_roll", RUNS, {
+    sample_buffer_10_push(&samples, sample++);
+    bucket_buffer_30_roll(&buckets, &samples.super);
+  });
+
+  fill_samples();
+  BENCH("print_sample_buffer", 4, print_sample_buffer(&samples.super, &null_stream));
+  BENCH("print_bucket_buffer", 4, print_bucket_buffer(&buckets.super, &null_stream));
+
+  // Steady readings, once the ring is full so every push evicts
+  delta_buffer_338_init(&history);
+  for (uint16_t i = 0; i < 2 * sizeof(history.nibbles); i++) {
+    delta_buffer_push(&history.super, 40 + (i & 1));
+  }
+  BENCH("delta_buffer_push", RUNS, delta_buffer_push(&history.super, 40 + (sample++ & 1)));
+  BENCH("delta_buffer_push_step", RUNS, delta_buffer_push(&history.super, sample += 16));
+  BENCH("print_delta_buffer", 1, print_delta_buffer(&history.super, &null_stream));
+}
+
+static void bench_hum_temp(void) {
+  hum_temp_init();
+  BENCH("hum_temp_current_stats", RUNS, (void) hum_temp_current_stats(0));
+  BENCH("hum_temp_print_stats", 4, hum_temp_print_stats(&null_stream));
+}
+
+// Plays the sensor's side of a read on the data pin, with the pin
+// driven as an output so each write raises the pin-change interrupt.
+// The figures are per edge, interrupt entry and exit included. The
+// waits are in wait_us units, which run about a quarter long, and
+// aim for 20us to the response, 80us response phases, 50us low gaps
+// and 27us/70us bits once the measuring around each edge is added.
+static void bench_dht11(void) {
+  static const uint8_t frame[5] = { 45, 0, 21, 0, 66 };
+
+  DDRC |= _BV(sensor_gpio.pin);
+  PORTC |= _BV(sensor_gpio.pin);
+  uint32_t toggle = edge(true);
+
+  uint16_t stack_top = SP;
+  paint_stack();
+  uint32_t total = 0;
+  uint32_t max = 0;
+  uint8_t edges = 0;
+
+  dht11_signal_start(&sensor_gpio);
+  dht11_begin_read(&sensor_gpio);
+  DDRC |= _BV(sensor_gpio.pin);
+  PORTC |= _BV(sensor_gpio.pin);
+
+  uint32_t elapsed;
+  for (uint8_t i = 0; i < 3 + 2 * 8 * sizeof(frame); i++) {
+    uint8_t bit = i >= 3 ? (i - 3) >> 1 : 0;
+    bool one = frame[bit >> 3] & (0x80 >> (bit & 7));
+    if (i == 0) {
+      wait_us(12);
+    } else if (i < 3) {
+      wait_us(56);
+    } else if (i & 1) {
+      wait_us(32);
+    } else {
+      wait_us(one ? 48 : 14);
+    }
+    // Falling edges start the response and end each data bit
+    elapsed = edge(i == 1 || (i >= 3 && (i & 1))) - toggle;
+    total += elapsed;
+    if (elapsed > max) max = elapsed;
+    edges++;
+  }
+  wait_us(32);
+  edge(true);
+  report(PSTR("dht11_edge"), edges, total / edges, max, stack_top - stack_low_water());
+
+  uint8_t data[5];
+  BENCH("dht11_end_read", 1, dht11_end_read(&sensor_gpio, data));
+}
+
+static void bench_sample_log(void) {
+  sample_log_init();
+  struct sample_log_entry entry = { .sums = { 450, 210 }, .samples = 10 };
+
+  // The append only queues the entry; the EE_READY interrupt writes it
+  BENCH("sample_log_append", 1, sample_log_append(&entry));
+  eeprom_writer_wait();
+  entry.sums[0]++;
+  BENCH("sample_log_append_complete", 1, {
+    sample_log_append(&entry);
+    eeprom_writer_wait();
+  });
+}
+
+// push_sample as it was, with a runtime 16-bit modulo for each wrap
+static void modulo_push_sample(struct modulo_buffer* buffer, const uint8_t sample) {
+  if (buffer->count == buffer->size) {
+    buffer->sum -= buffer->samples[buffer->start];
+  }
+
+  uint16_t end = (buffer->start + buffer->count) % buffer->size;
+  buffer->samples[end] = sample;
+  buffer->sum += sample;
+
+  if (buffer->count == buffer->size) {
+    buffer->start = (buffer->start + 1) % buffer->size;
+  } else {
+    buffer->count++;
+  }
+}
+
+static void fill_samples(void) {
+  for (uint8_t i = 0; i < ARRAY_SIZE(samples.samples); i++) {
+    sample_buffer_10_push(&samples, 40 + i);
+  }
+}
+
+static uint32_t edge(uint8_t high) {
+  uint32_t start = cycles();
+  if (high) {
+    PORTC |= _BV(sensor_gpio.pin);
+  } else {
+    PORTC &= ~_BV(sensor_gpio.pin);
+  }
+  __asm__ __volatile__ ("nop");
+  return cycles() - start - cycles_overhead;
+}
+
+static void wait_us(uint8_t us) {
+  while (us--) {
+    _delay_us(1);
+  }
+}
+
+ISR(TIMER1_OVF_vect) {
+  overflows++;
+}
+
+// A pending overflow is counted if TCNT1 has already wrapped
+static uint32_t cycles(void) {
+  uint16_t high;
+  uint16_t low;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    low = TCNT1;
+    high = overflows;
+    if ((TIFR1 & _BV(TOV1)) && low < 0x8000) {
+      high++;
+    }
+  }
+  return ((uint32_t) high << 16) | low;
+}
+
+static void paint_stack(void) {
+  uint8_t* end = (uint8_t*) SP;
+  for (uint8_t* p = &__heap_start; p < end; p++) {
+    *p = STACK_PAINT;
+  }
+}
+
+static uint16_t stack_low_water(void) {
+  uint8_t* p = &__heap_start;
+  while (*p == STACK_PAINT && p < (uint8_t*) SP) {
+    p++;
+  }
+  return (uint16_t) p;
+}
+
+static void report(PGM_P name, uint16_t runs, uint32_t mean, uint32_t max, uint16_t stack) {
+  printf_P(PSTR("bench,%S,%u,%lu,%lu,%u\n"), name, runs, mean, max, stack);
+}
+
+static int console_put(char c, FILE* stream) {
+  GPIOR0 = c;
+  return 0;
+}
+
+static int null_put(char c, FILE* stream) {
+  return 0;
+}
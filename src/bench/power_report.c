@@ -0,0 +1,60 @@
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+
+#include "avr_mcu_section.h"
+
+#include "common.h"
+#include "power.h"
+#include "print.h"
+#include "scheduler.h"
+
+// Power report for wetector-power.elf, which is the firmware plus this
+// file, linked with -Wl,--wrap=power_init so that power_init also
+// schedules the report. After POWER_REPORT_MINUTES of simulated time
+// the figures go out through the simavr console register as
+//   power,<sleeps>,<asleep ms>,<awake ms>
+// and the CPU stops, which ends the simulation.
+//
+// No figure has been taken with it yet: simavr was not available where
+// this was written, so how much of the time the firmware sleeps is
+// still to be measured.
+
+AVR_MCU(F_CPU, "atmega328p");
+AVR_MCU_SIMAVR_CONSOLE(&GPIOR0);
+
+#define POWER_REPORT_MINUTES 60
+
+void __real_power_init(void);
+void __wrap_power_init(void);
+
+static void report_task(struct task* task);
+static int console_put(char c, FILE* stream);
+
+static FILE console = FDEV_SETUP_STREAM(console_put, NULL, _FDEV_SETUP_WRITE);
+
+void __wrap_power_init(void) {
+  __real_power_init();
+  struct task_config report_task_config = { "pwrpt", POWER_REPORT_MINUTES, 60000 };
+  scheduler_add_task(&report_task_config, report_task, NULL);
+}
+
+static void report_task(struct task* task) {
+  if (task->times_run < POWER_REPORT_MINUTES) return;
+  struct power_stats stats;
+  power_get_stats(&stats);
+  print_format_P(&console, PSTR("power,%lu,%lu,%lu\n"), stats.sleeps, stats.asleep_ms, stats.awake_ms);
+  cli();
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  sleep_cpu();
+}
+
+static int console_put(char c, FILE* stream) {
+  GPIOR0 = c;
+  return 0;
+}
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Turns the simulator log and the firmware's section sizes into
+# metric,value rows, adding baseline,delta columns when a baseline
+# file from an earlier run exists.
+#
+# usage: report.sh <simavr log> <avr-size> <wetector.elf> <baseline.csv>
+
+log=$1
+avr_size=$2
+elf=$3
+baseline=$4
+
+metrics() {
+  # bench,<name>,<runs>,<mean>,<max>,<stack>; simavr may prefix lines
+  sed -n 's/^.*bench,//p' "$log" | awk -F, '{
+    print $1 ".cycles," $3
+    print $1 ".cycles_max," $4
+    print $1 ".stack," $5
+  }'
+  $avr_size -A "$elf" | awk '
+    $1 == ".text" { text = $2 }
+    $1 == ".data" { data = $2 }
+    $1 == ".bss" { bss = $2 }
+    END {
+      print "flash," text + data
+      print "sram," data + bss
+    }'
+}
+
+if [ -f "$baseline" ]; then
+  metrics | awk -F, -v baseline="$baseline" '
+    BEGIN { while ((getline line < baseline) > 0) { split(line, f, ","); base[f[1]] = f[2] } }
+    $1 in base { print $1 "," $2 "," base[$1] "," $2 - base[$1]; next }
+    { print $1 "," $2 ",," }'
+else
+  metrics
+fi
@@ -0,0 +1,181 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <util/crc16.h>
+
+#include "dht11.h"
+#include "hum_temp.h"
+#include "telemetry.h"
+
+// Reads the device's output on stdin and turns telemetry frames (see
+// telemetry.h) into text on stdout:
+//
+//   stats,<sensor>,<channel>,<mean 20s>,<mean 10m>
+//   diag,<result>,<bits>,<pulse min>,<pulse max>,<threshold>,<ok>,<st1>,<st2>,<cks>,<tmo>
+//   samples,<sensor>,<buffer>,<sample>,...       empty for a failed read
+//   buckets,<sensor>,<buffer>,<window mean>,...
+//
+// Buffers print once their last packet is in. Anything between frames
+// that doesn't decode, such as shell text, is skipped; a count of
+// frames, skipped bytes and seq gaps goes to stderr at the end.
+//
+// usage: wetector-decode < capture
+
+#define MAX_FRAME 256
+#define MAX_BUFFER_SAMPLES 1024
+#define MAX_SENSORS 8
+#define BUFFER_COUNT (MAX_SENSORS * TELEMETRY_BUFFER_KINDS)
+
+struct buffer_state {
+  uint16_t count;
+  uint16_t received;
+  uint8_t window;
+  uint16_t values[MAX_BUFFER_SAMPLES];
+};
+
+static const char* buffer_names[TELEMETRY_BUFFER_KINDS] = { "H20s", "H10m", "T20s", "T10m" };
+static struct buffer_state buffers[BUFFER_COUNT];
+
+static unsigned long frames;
+static unsigned long skipped;
+static unsigned long gaps;
+static int last_seq = -1;
+
+static size_t cobs_decode(const uint8_t* in, size_t length, uint8_t* out);
+static void handle_packet(const uint8_t* packet, size_t length);
+static void handle_samples(const uint8_t* payload, size_t length, int buckets);
+static uint16_t word_at(const uint8_t* bytes);
+static double fixed(uint16_t value);
+
+int main(int argc, char** argv) {
+  uint8_t frame[MAX_FRAME];
+  uint8_t packet[MAX_FRAME];
+  size_t length = 0;
+  int overflow = 0;
+  int c;
+  while ((c = getchar()) != EOF) {
+    if (c != 0) {
+      if (length < MAX_FRAME) {
+        frame[length++] = c;
+      } else {
+        overflow = 1;
+        skipped++;
+      }
+      continue;
+    }
+    if (length > 0) {
+      size_t decoded = overflow ? 0 : cobs_decode(frame, length, packet);
+      if (decoded >= 4) {
+        uint16_t crc = TELEMETRY_CRC_SEED;
+        for (size_t i = 0; i < decoded - 2; i++) {
+          crc = _crc_ccitt_update(crc, packet[i]);
+        }
+        if (crc == word_at(&packet[decoded - 2])) {
+          handle_packet(packet, decoded - 2);
+          length = 0;
+          continue;
+        }
+      }
+      skipped += length;
+    }
+    length = 0;
+    overflow = 0;
+  }
+  skipped += length;
+  fprintf(stderr, "%lu frames, %lu bytes skipped, %lu seq gaps\n", frames, skipped, gaps);
+  return 0;
+}
+
+// Returns the decoded length, or 0 if a code byte runs past the end
+static size_t cobs_decode(const uint8_t* in, size_t length, uint8_t* out) {
+  size_t read = 0;
+  size_t written = 0;
+  while (read < length) {
+    uint8_t code = in[read++];
+    if (read + code - 1 > length) return 0;
+    for (uint8_t i = 1; i < code; i++) {
+      out[written++] = in[read++];
+    }
+    if (code < 0xFF && read < length) {
+      out[written++] = 0;
+    }
+  }
+  return written;
+}
+
+static void handle_packet(const uint8_t* packet, size_t length) {
+  frames++;
+  if (last_seq >= 0 && packet[1] != (uint8_t) (last_seq + 1)) {
+    gaps++;
+  }
+  last_seq = packet[1];
+
+  const uint8_t* payload = &packet[2];
+  length -= 2;
+  switch (packet[0]) {
+  case TELEMETRY_TYPE_STATS:
+    if (length < 9) break;
+    printf("stats,%u,H,%.2f,%.2f\n", payload[0], fixed(word_at(&payload[1])), fixed(word_at(&payload[3])));
+    printf("stats,%u,T,%.2f,%.2f\n", payload[0], fixed(word_at(&payload[5])), fixed(word_at(&payload[7])));
+    break;
+  case TELEMETRY_TYPE_DIAGNOSTICS:
+    if (length < 8 + 2 * DHT11_RESULT_COUNT) break;
+    printf("diag,%u,%u,%u,%u,%u", payload[0], payload[1],
+      word_at(&payload[2]), word_at(&payload[4]), word_at(&payload[6]));
+    for (uint8_t i = 0; i < DHT11_RESULT_COUNT; i++) {
+      printf(",%u", word_at(&payload[8 + 2 * i]));
+    }
+    printf("\n");
+    break;
+  case TELEMETRY_TYPE_SAMPLES:
+    handle_samples(payload, length, 0);
+    break;
+  case TELEMETRY_TYPE_BUCKETS:
+    handle_samples(payload, length, 1);
+    break;
+  }
+}
+
+static void handle_samples(const uint8_t* payload, size_t length, int buckets) {
+  size_t header = buckets ? 6 : 5;
+  if (length < header || payload[0] >= BUFFER_COUNT) return;
+  struct buffer_state* buffer = &buffers[payload[0]];
+  uint8_t window = buckets ? payload[1] : 1;
+  uint16_t offset = word_at(&payload[header - 4]);
+  uint16_t count = word_at(&payload[header - 2]);
+  if (count > MAX_BUFFER_SAMPLES) return;
+  if (offset == 0) {
+    buffer->count = count;
+    buffer->received = 0;
+    buffer->window = window;
+  }
+  if (offset != buffer->received || count != buffer->count) return;
+
+  size_t values = (length - header) / (buckets ? 2 : 1);
+  for (size_t i = 0; i < values && buffer->received < count; i++) {
+    buffer->values[buffer->received++] = buckets ? word_at(&payload[header + 2 * i]) : payload[header + i];
+  }
+  if (buffer->received < count) return;
+
+  printf("%s,%u,%s", buckets ? "buckets" : "samples", payload[0] / TELEMETRY_BUFFER_KINDS,
+    buffer_names[payload[0] % TELEMETRY_BUFFER_KINDS]);
+  for (uint16_t i = 0; i < count; i++) {
+    if (buckets) {
+      printf(",%.1f", (double) buffer->values[i] / buffer->window);
+    } else if (buffer->values[i] == TELEMETRY_INVALID_SAMPLE) {
+      printf(",");
+    } else {
+      printf(",%u", buffer->values[i]);
+    }
+  }
+  printf("\n");
+  buffer->received = 0;
+}
+
+static uint16_t word_at(const uint8_t* bytes) {
+  return bytes[0] | (bytes[1] << 8);
+}
+
+static double fixed(uint16_t value) {
+  return (double) value / (1 << HUM_TEMP_FRACTION_BITS);
+}
@@ -0,0 +1,21 @@
+
+#include <inttypes.h>
+
+#include "clock.h"
+#include "host.h"
+
+static uint64_t now;
+
+uint32_t clock_get_millis(void) {
+  return (uint32_t) now;
+}
+
+uint64_t host_clock_now(void) {
+  return now;
+}
+
+void host_clock_set(uint64_t time) {
+  if (time > now) {
+    now = time;
+  }
+}
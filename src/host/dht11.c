@@ -0,0 +1,143 @@
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dht11.h"
+#include "host.h"
+#include "log.h"
+
+// Scripted stand-in for the DHT11 decoder. Each read takes the next
+// frame from a text script, one line per read:
+//
+//   <humidity> <temperature>   a good frame
+//   fail [start1|start2|checksum|timeout]
+//                              a failed read (timeout if not given)
+//   > <shell line>             runs a shell command, takes no read
+//   # ...                      comment
+//
+// A path of "-" reads the script from stdin. Once the script runs out
+// every read times out and host_dht11_done turns true.
+// host_dht11_set_source swaps the script for another frame source,
+// such as the trace replay.
+
+#define SCRIPT_LINE_LENGTH 80
+
+static const char* const fail_names[DHT11_RESULT_COUNT] = {
+  [DHT11_RESULT_FAIL_START_1] = "start1",
+  [DHT11_RESULT_FAIL_START_2] = "start2",
+  [DHT11_RESULT_FAIL_CHECKSUM] = "checksum",
+  [DHT11_RESULT_FAIL_TIMEOUT] = "timeout"
+};
+
+static FILE* script;
+static uint32_t script_line;
+static uint32_t reads;
+static bool done;
+static host_dht11_source source;
+static struct dht11_diagnostics diagnostics;
+
+static result_t next_frame(uint8_t* data);
+static result_t parse_fail(const char* reason);
+static result_t record(result_t result);
+
+bool host_dht11_open(const char* path) {
+  script = string_eq(path, "-") ? stdin : fopen(path, "r");
+  script_line = 0;
+  done = script == NULL;
+  return script != NULL;
+}
+
+void host_dht11_close(void) {
+  if (script != NULL && script != stdin) {
+    fclose(script);
+    script = NULL;
+  }
+  done = true;
+}
+
+bool host_dht11_done(void) {
+  return done;
+}
+
+uint32_t host_dht11_reads(void) {
+  return reads;
+}
+
+void host_dht11_set_source(host_dht11_source frame_source) {
+  source = frame_source;
+}
+
+void dht11_signal_start(const struct gpio* gpio) {
+}
+
+void dht11_begin_read(const struct gpio* gpio) {
+}
+
+result_t dht11_end_read(const struct gpio* gpio, uint8_t* data) {
+  memset(data, 0, 5);
+  reads++;
+  result_t result = source != NULL ? source(data) : next_frame(data);
+  diagnostics.bits = result == DHT11_RESULT_SUCCESS ? 40 : 0;
+  return record(result);
+}
+
+const struct dht11_diagnostics* dht11_diagnostics(void) {
+  return &diagnostics;
+}
+
+void dht11_reset_diagnostics(void) {
+  diagnostics = (struct dht11_diagnostics) { 0 };
+}
+
+uint16_t dht11_ticks_to_us(uint8_t ticks) {
+  return ticks;
+}
+
+static result_t next_frame(uint8_t* data) {
+  char line[SCRIPT_LINE_LENGTH];
+  while (!done && fgets(line, sizeof(line), script) != NULL) {
+    script_line++;
+    line[strcspn(line, "\r\n")] = '\0';
+
+    char* text = line + strspn(line, " \t");
+    if (*text == '\0' || *text == '#') continue;
+    if (*text == '>') {
+      host_shell_execute(text + 1);
+      continue;
+    }
+    if (strncmp(text, "fail", 4) == 0) {
+      return parse_fail(text + 4);
+    }
+
+    unsigned humidity, temperature;
+    if (sscanf(text, "%u %u", &humidity, &temperature) != 2 || humidity > UINT8_MAX || temperature > UINT8_MAX) {
+      LOG_ERROR("DHT11 script line %lu not understood: %s\n", (unsigned long) script_line, text);
+      continue;
+    }
+    data[0] = humidity;
+    data[2] = temperature;
+    data[4] = data[0] + data[2];
+    return DHT11_RESULT_SUCCESS;
+  }
+
+  done = true;
+  return DHT11_RESULT_FAIL_TIMEOUT;
+}
+
+static result_t parse_fail(const char* reason) {
+  reason += strspn(reason, " \t");
+  for (uint8_t result = DHT11_RESULT_FAIL_START_1; result < DHT11_RESULT_COUNT; result++) {
+    if (string_eq(reason, fail_names[result])) return result;
+  }
+  return DHT11_RESULT_FAIL_TIMEOUT;
+}
+
+static result_t record(result_t result) {
+  diagnostics.result = result;
+  if (diagnostics.results[result] < UINT16_MAX) {
+    diagnostics.results[result]++;
+  }
+  return result;
+}
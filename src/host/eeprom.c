@@ -0,0 +1,129 @@
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <avr/io.h>
+
+#include "eeprom_writer.h"
+#include "host.h"
+#include "log.h"
+
+// File-backed stand-in for the EEPROM and for eeprom_writer, whose
+// device version is driven by the EE_READY interrupt. Writes land
+// straight away with the same update semantics, so eeprom_writer is
+// never busy.
+
+static uint8_t image[E2END + 1];
+static const char* image_path;
+static uint32_t bytes_written;
+
+static uint16_t checked_address(const volatile void* address, size_t length);
+static void update(uint16_t address, const void* data, size_t length);
+
+bool host_eeprom_open(const char* path) {
+  image_path = path;
+  memset(image, 0xFF, sizeof(image));
+
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) return true;
+  size_t length = fread(image, 1, sizeof(image), file);
+  fclose(file);
+  if (length != sizeof(image)) {
+    LOG_ERROR("EEPROM image %s is %u bytes, expected %u\n", path, (unsigned) length, (unsigned) sizeof(image));
+    return false;
+  }
+  return true;
+}
+
+bool host_eeprom_close(void) {
+  if (image_path == NULL) return true;
+
+  FILE* file = fopen(image_path, "wb");
+  if (file == NULL) return false;
+  size_t length = fwrite(image, 1, sizeof(image), file);
+  return fclose(file) == 0 && length == sizeof(image);
+}
+
+uint32_t host_eeprom_bytes_written(void) {
+  return bytes_written;
+}
+
+uint8_t eeprom_writer_write(uint16_t address, const void* data, uint8_t length) {
+  if (length > EEPROM_WRITER_BUFFER_SIZE) {
+    length = EEPROM_WRITER_BUFFER_SIZE;
+  }
+  update(address, data, length);
+  return length;
+}
+
+bool eeprom_writer_busy(void) {
+  return false;
+}
+
+void eeprom_writer_wait(void) {
+}
+
+uint8_t eeprom_read_byte(const uint8_t* address) {
+  return image[checked_address(address, 1)];
+}
+
+uint16_t eeprom_read_word(const uint16_t* address) {
+  uint16_t value;
+  eeprom_read_block(&value, address, sizeof(value));
+  return value;
+}
+
+uint32_t eeprom_read_dword(const uint32_t* address) {
+  uint32_t value;
+  eeprom_read_block(&value, address, sizeof(value));
+  return value;
+}
+
+void eeprom_read_block(void* dest, const void* source, size_t length) {
+  memcpy(dest, &image[checked_address(source, length)], length);
+}
+
+void eeprom_write_byte(uint8_t* address, uint8_t value) {
+  uint16_t index = checked_address(address, 1);
+  image[index] = value;
+  bytes_written++;
+}
+
+void eeprom_update_byte(uint8_t* address, uint8_t value) {
+  update(checked_address(address, 1), &value, 1);
+}
+
+void eeprom_update_word(uint16_t* address, uint16_t value) {
+  update(checked_address(address, sizeof(value)), &value, sizeof(value));
+}
+
+void eeprom_update_dword(uint32_t* address, uint32_t value) {
+  update(checked_address(address, sizeof(value)), &value, sizeof(value));
+}
+
+void eeprom_update_block(const void* source, void* dest, size_t length) {
+  update(checked_address(dest, length), source, length);
+}
+
+// EEPROM addresses reach us cast to pointers, as they do on the device;
+// one past the end is a firmware bug, so stop there
+static uint16_t checked_address(const volatile void* address, size_t length) {
+  uintptr_t index = (uintptr_t) address;
+  if (index + length > sizeof(image)) {
+    fprintf(stderr, "EEPROM access out of range: %lu+%lu\n", (unsigned long) index, (unsigned long) length);
+    abort();
+  }
+  return index;
+}
+
+static void update(uint16_t address, const void* data, size_t length) {
+  checked_address((const volatile void*) (uintptr_t) address, length);
+  const uint8_t* bytes = (const uint8_t*) data;
+  for (size_t i = 0; i < length; i++) {
+    if (image[address + i] == bytes[i]) continue;
+    image[address + i] = bytes[i];
+    bytes_written++;
+  }
+}
@@ -0,0 +1,51 @@
+
+#include <inttypes.h>
+
+#include "event/event.h"
+#include "log.h"
+
+struct listener {
+  uint8_t type;
+  uint8_t descriptor;
+  event_handler handler;
+};
+
+static struct listener listeners[EVENT_MAX_LISTENERS];
+static uint8_t listener_count;
+
+static int8_t find_listener(uint8_t type, uint8_t descriptor, event_handler handler);
+
+void event_add_listener(uint8_t type, uint8_t descriptor, event_handler handler) {
+  if (find_listener(type, descriptor, handler) >= 0) return;
+  if (listener_count == EVENT_MAX_LISTENERS) {
+    LOG_ERROR("No room for a listener on event %u/%u\n", type, descriptor);
+    return;
+  }
+  listeners[listener_count++] = (struct listener) { type, descriptor, handler };
+}
+
+void event_remove_listener(uint8_t type, uint8_t descriptor, event_handler handler) {
+  int8_t index = find_listener(type, descriptor, handler);
+  if (index < 0) return;
+
+  for (uint8_t i = index + 1; i < listener_count; i++) {
+    listeners[i - 1] = listeners[i];
+  }
+  listener_count--;
+}
+
+void event_fire_event(event_t* event) {
+  for (uint8_t i = 0; i < listener_count; i++) {
+    if (listeners[i].type != event->type || listeners[i].descriptor != event->descriptor) continue;
+    if (listeners[i].handler(event)) break;
+  }
+}
+
+static int8_t find_listener(uint8_t type, uint8_t descriptor, event_handler handler) {
+  for (uint8_t i = 0; i < listener_count; i++) {
+    if (listeners[i].type == type && listeners[i].descriptor == descriptor && listeners[i].handler == handler) {
+      return i;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,81 @@
+
+#include <inttypes.h>
+#include <avr/io.h>
+
+#include "event/gpio_event.h"
+#include "hal/hal.h"
+#include "host.h"
+
+volatile uint8_t host_io[0x100];
+
+// Duty cycle and frequency last set on each pin, for stand-ins and
+// tools that want to see what the LEDs and speaker would be doing
+static uint8_t duty_cycles[GPIO_PORT_COUNT][8];
+static uint8_t frequencies[GPIO_PORT_COUNT][8];
+
+void gpio_port_regs(const struct gpio* gpio, struct gpio_regs* regs) {
+  switch (gpio->port) {
+    case GPIO_PORT_B:
+      *regs = (struct gpio_regs) { &PORTB, &DDRB, &PINB };
+      break;
+    case GPIO_PORT_C:
+      *regs = (struct gpio_regs) { &PORTC, &DDRC, &PINC };
+      break;
+    default:
+      *regs = (struct gpio_regs) { &PORTD, &DDRD, &PIND };
+      break;
+  }
+}
+
+void gpio_set_mode(const struct gpio* gpio, uint8_t mode) {
+  struct gpio_regs regs;
+  gpio_port_regs(gpio, &regs);
+  if (mode == GPIO_OUTPUT) {
+    *(regs.port_direction_reg) |= _BV(gpio->pin);
+  } else {
+    *(regs.port_direction_reg) &= ~_BV(gpio->pin);
+  }
+}
+
+// With nothing driving the inputs, a pin reads back what it outputs
+void gpio_write(const struct gpio* gpio, uint8_t level) {
+  struct gpio_regs regs;
+  gpio_port_regs(gpio, &regs);
+  if (level == LOGIC_HIGH) {
+    *(regs.port_data_reg) |= _BV(gpio->pin);
+    *(regs.port_input_reg) |= _BV(gpio->pin);
+  } else {
+    *(regs.port_data_reg) &= ~_BV(gpio->pin);
+    *(regs.port_input_reg) &= ~_BV(gpio->pin);
+  }
+}
+
+uint8_t gpio_read(const struct gpio* gpio) {
+  struct gpio_regs regs;
+  gpio_port_regs(gpio, &regs);
+  return (*(regs.port_input_reg) & _BV(gpio->pin)) ? LOGIC_HIGH : LOGIC_LOW;
+}
+
+void gpio_set_duty_cycle(const struct gpio* gpio, uint8_t duty_cycle) {
+  duty_cycles[gpio->port][gpio->pin] = duty_cycle;
+}
+
+void gpio_set_frequency(const struct gpio* gpio, uint8_t frequency) {
+  frequencies[gpio->port][gpio->pin] = frequency;
+}
+
+uint8_t host_gpio_duty_cycle(const struct gpio* gpio) {
+  return duty_cycles[gpio->port][gpio->pin];
+}
+
+uint8_t host_gpio_frequency(const struct gpio* gpio) {
+  return frequencies[gpio->port][gpio->pin];
+}
+
+void gpio_event_add_listener(const struct gpio* gpio, event_handler handler) {
+  event_add_listener(EVENT_TYPE_GPIO, gpio_to_descriptor(gpio), handler);
+}
+
+uint8_t gpio_to_descriptor(const struct gpio* gpio) {
+  return (gpio->port << 3) | gpio->pin;
+}
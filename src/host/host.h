@@ -0,0 +1,60 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "common.h"
+#include "hal/hal.h"
+
+// Controls for the host stand-ins that firmware code never calls
+
+// Virtual clock, in ms since the run started
+uint64_t host_clock_now(void);
+
+void host_clock_set(uint64_t now);
+
+// Runs every task due at or before until, in due order, moving the
+// clock to each task as it runs and finally to until
+void host_scheduler_run_until(uint64_t until);
+
+// Loads the EEPROM image from path, or starts from an erased one if the
+// file does not exist. host_eeprom_close writes it back.
+bool host_eeprom_open(const char* path);
+
+bool host_eeprom_close(void);
+
+uint32_t host_eeprom_bytes_written(void);
+
+// Last duty cycle and frequency the firmware set on a pin
+uint8_t host_gpio_duty_cycle(const struct gpio* gpio);
+
+uint8_t host_gpio_frequency(const struct gpio* gpio);
+
+// Scripted DHT11: one frame per read from the script, see dht11.c
+bool host_dht11_open(const char* path);
+
+void host_dht11_close(void);
+
+bool host_dht11_done(void);
+
+uint32_t host_dht11_reads(void);
+
+// Fills in a 5 byte DHT11 frame and returns a DHT11_RESULT_*
+typedef result_t (*host_dht11_source)(uint8_t* data);
+
+void host_dht11_set_source(host_dht11_source source);
+
+// Trace replay, see replay.c
+bool host_replay_open(const char* path, FILE* out);
+
+result_t host_replay_frame(uint8_t* data);
+
+bool host_replay_done(void);
+
+void host_replay_close(void);
+
+// Runs one shell line, as if typed at the serial console
+void host_shell_execute(char* line);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef HOST_AVR_EEPROM_H
+#define HOST_AVR_EEPROM_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+// Backed by the image loaded with host_eeprom_open; writes complete
+// immediately.
+#define EEMEM
+
+#define eeprom_is_ready() 1
+#define eeprom_busy_wait() ((void) 0)
+
+uint8_t eeprom_read_byte(const uint8_t* address);
+
+uint16_t eeprom_read_word(const uint16_t* address);
+
+uint32_t eeprom_read_dword(const uint32_t* address);
+
+void eeprom_read_block(void* dest, const void* source, size_t length);
+
+void eeprom_write_byte(uint8_t* address, uint8_t value);
+
+void eeprom_update_byte(uint8_t* address, uint8_t value);
+
+void eeprom_update_word(uint16_t* address, uint16_t value);
+
+void eeprom_update_dword(uint32_t* address, uint32_t value);
+
+void eeprom_update_block(const void* source, void* dest, size_t length);
+
+#endif
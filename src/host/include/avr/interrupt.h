@@ -0,0 +1,13 @@
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+// The host is single threaded: an ISR is a plain function that runs
+// only when a stand-in calls it.
+#define ISR(VECTOR, ...) void VECTOR(void); void VECTOR(void)
+
+#define sei() ((void) 0)
+#define cli() ((void) 0)
+
+#endif
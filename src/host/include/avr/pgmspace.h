@@ -0,0 +1,29 @@
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+// Flash and RAM share one address space on the host, so every _P
+// function is its RAM twin and a pgm_read_* is a plain load through a
+// pointer of the right type (pointers are wider than a word here).
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(S) (S)
+
+#define pgm_read_byte(ADDR) (*(ADDR))
+#define pgm_read_word(ADDR) (*(ADDR))
+#define pgm_read_dword(ADDR) (*(ADDR))
+#define pgm_read_ptr(ADDR) (*(ADDR))
+
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define memcpy_P memcpy
+#define printf_P printf
+#define fprintf_P fprintf
+#define fputs_P fputs
+#define snprintf_P snprintf
+
+#endif
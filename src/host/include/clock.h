@@ -0,0 +1,9 @@
+#ifndef HOST_CLOCK_H
+#define HOST_CLOCK_H
+
+#include <inttypes.h>
+
+// Virtual time, moved on by the host scheduler rather than a timer
+uint32_t clock_get_millis(void);
+
+#endif
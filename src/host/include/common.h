@@ -0,0 +1,22 @@
+#ifndef HOST_COMMON_H
+#define HOST_COMMON_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "defs.h"
+
+// Host stand-ins for the parts of sensimatic wetector uses. They keep
+// sensimatic's names and signatures so the firmware sources build
+// unchanged; see host.h for the extra controls the host build adds.
+
+typedef uint8_t result_t;
+
+#define RESULT_SUCCESS 0
+#define RESULT_FAIL 1
+
+#define ARRAY_SIZE(ARRAY) (sizeof(ARRAY) / sizeof((ARRAY)[0]))
+
+bool string_eq(const char* a, const char* b);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef HOST_EVENT_H
+#define HOST_EVENT_H
+
+#include <inttypes.h>
+
+#include "common.h"
+
+typedef struct event {
+  uint8_t type;
+  uint8_t descriptor;
+} event_t;
+
+// Returning true stops the event reaching later listeners
+typedef bool (*event_handler)(event_t* event);
+
+// Adding the same handler for the same event twice is a no-op
+void event_add_listener(uint8_t type, uint8_t descriptor, event_handler handler);
+
+void event_remove_listener(uint8_t type, uint8_t descriptor, event_handler handler);
+
+void event_fire_event(event_t* event);
+
+#endif
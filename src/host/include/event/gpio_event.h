@@ -0,0 +1,25 @@
+#ifndef HOST_GPIO_EVENT_H
+#define HOST_GPIO_EVENT_H
+
+#include <inttypes.h>
+
+#include "common.h"
+#include "event/event.h"
+#include "hal/hal.h"
+
+#define EVENT_TYPE_GPIO 0x01
+
+enum gpio_event_type {
+  GPIO_DOWN, GPIO_UP
+};
+
+typedef struct {
+  event_t super;
+  uint8_t event_type;
+} gpio_event_t;
+
+void gpio_event_add_listener(const struct gpio* gpio, event_handler handler);
+
+uint8_t gpio_to_descriptor(const struct gpio* gpio);
+
+#endif
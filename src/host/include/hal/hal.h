@@ -0,0 +1,47 @@
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <inttypes.h>
+
+#include "common.h"
+
+enum gpio_port {
+  GPIO_PORT_B, GPIO_PORT_C, GPIO_PORT_D, GPIO_PORT_COUNT
+};
+
+enum gpio_pin {
+  GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2, GPIO_PIN_3, GPIO_PIN_4, GPIO_PIN_5, GPIO_PIN_6, GPIO_PIN_7
+};
+
+enum gpio_mode {
+  GPIO_INPUT, GPIO_OUTPUT
+};
+
+enum logic_level {
+  LOGIC_LOW, LOGIC_HIGH
+};
+
+struct gpio {
+  uint8_t port;
+  uint8_t pin;
+};
+
+struct gpio_regs {
+  volatile uint8_t* port_data_reg;
+  volatile uint8_t* port_direction_reg;
+  volatile uint8_t* port_input_reg;
+};
+
+void gpio_port_regs(const struct gpio* gpio, struct gpio_regs* regs);
+
+void gpio_set_mode(const struct gpio* gpio, uint8_t mode);
+
+void gpio_write(const struct gpio* gpio, uint8_t level);
+
+uint8_t gpio_read(const struct gpio* gpio);
+
+void gpio_set_duty_cycle(const struct gpio* gpio, uint8_t duty_cycle);
+
+void gpio_set_frequency(const struct gpio* gpio, uint8_t frequency);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef HOST_LOG_H
+#define HOST_LOG_H
+
+#include <inttypes.h>
+
+// Log lines go to stderr stamped with the virtual time
+#define LOG_DEBUG(FORMAT, ...) host_log('D', FORMAT, __VA_ARGS__)
+#define LOG_INFO(FORMAT, ...) host_log('I', FORMAT, __VA_ARGS__)
+#define LOG_ERROR(FORMAT, ...) host_log('E', FORMAT, __VA_ARGS__)
+
+void host_log(char level, const char* format, ...);
+
+#endif
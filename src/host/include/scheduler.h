@@ -0,0 +1,34 @@
+#ifndef HOST_SCHEDULER_H
+#define HOST_SCHEDULER_H
+
+#include <inttypes.h>
+
+#include "common.h"
+
+#define TASK_FOREVER 0
+#define TASK_ONCE 1
+#define TASK_ASAP 0
+#define TASK_NO_TASK 0xFF
+
+struct task {
+  uint8_t id;
+  const char* name;
+  uint16_t times_run;
+  void* data;
+};
+
+struct task_config {
+  const char* name;
+  uint16_t times;
+  uint16_t interval;
+};
+
+typedef void (*task_func)(struct task* task);
+
+// A task first runs interval ms after it is added, then every interval
+// ms until it has run times times (or forever)
+uint8_t scheduler_add_task(struct task_config* config, task_func func, void* data);
+
+void scheduler_remove_task(uint8_t id);
+
+#endif
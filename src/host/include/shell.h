@@ -0,0 +1,29 @@
+#ifndef HOST_SHELL_H
+#define HOST_SHELL_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "common.h"
+
+#define SHELL_MAX_ARGS 4
+
+typedef enum {
+  SHELL_RESULT_SUCCESS, SHELL_RESULT_FAIL
+} shell_result_t;
+
+typedef struct {
+  char* command;
+  char* args[SHELL_MAX_ARGS];
+  uint8_t args_count;
+} shell_command_t;
+
+typedef shell_result_t (*shell_handler_t)(shell_command_t* command);
+
+void shell_register_handler(const char* command, shell_handler_t handler);
+
+void shell_printf(const char* format, ...);
+
+FILE* shell_get_stream(void);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+#include <inttypes.h>
+
+// Nothing preempts the host, so the block just runs once
+#define ATOMIC_BLOCK(TYPE) for (uint8_t atomic_once = 1; atomic_once; atomic_once = 0)
+
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_FORCEON
+
+#endif
@@ -0,0 +1,18 @@
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "common.h"
+#include "host.h"
+#include "log.h"
+
+void host_log(char level, const char* format, ...) {
+  uint64_t now = host_clock_now();
+  fprintf(stderr, "%" PRIu64 ".%03u %c ", now / 1000, (unsigned) (now % 1000), level);
+
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+}
@@ -0,0 +1,107 @@
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host.h"
+#include "scheduler.h"
+
+// Runs the firmware on the host: setup_task boots wetector as it does
+// on the device, then the scheduler is driven on the virtual clock
+// until the DHT11 script or the replayed trace runs out, or the time
+// limit is reached. Time jumps straight from one task to the next, so
+// a run goes as fast as the host can execute the firmware.
+
+#define RUN_STEP 1000
+#define MAX_COMMANDS 4
+
+void setup_task(struct task* task);
+
+static void command_task(struct task* task);
+static void usage(const char* name);
+
+int main(int argc, char** argv) {
+  const char* eeprom_path = NULL;
+  const char* trace_path = NULL;
+  uint64_t limit = 0;
+  char* commands[MAX_COMMANDS];
+  uint8_t command_count = 0;
+
+  int option;
+  while ((option = getopt(argc, argv, "c:e:r:t:h")) != -1) {
+    switch (option) {
+      case 'c':
+        if (command_count < MAX_COMMANDS) {
+          commands[command_count++] = optarg;
+        }
+        break;
+      case 'e':
+        eeprom_path = optarg;
+        break;
+      case 'r':
+        trace_path = optarg;
+        break;
+      case 't':
+        limit = strtoull(optarg, NULL, 10) * 1000;
+        break;
+      default:
+        usage(argv[0]);
+        return option == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+  if (optind != argc - (trace_path == NULL ? 1 : 0)) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (eeprom_path != NULL && !host_eeprom_open(eeprom_path)) return EXIT_FAILURE;
+  bool (*finished)(void) = host_dht11_done;
+  if (trace_path != NULL) {
+    if (!host_replay_open(trace_path, stdout)) {
+      perror(trace_path);
+      return EXIT_FAILURE;
+    }
+    host_dht11_set_source(host_replay_frame);
+    finished = host_replay_done;
+  } else if (!host_dht11_open(argv[optind])) {
+    perror(argv[optind]);
+    return EXIT_FAILURE;
+  }
+
+  clock_t started = clock();
+  scheduler_add_task(&(struct task_config) { "setup", TASK_ONCE, TASK_ASAP }, setup_task, NULL);
+  // Queued behind setup_task, so the shell handlers are registered
+  for (uint8_t i = 0; i < command_count; i++) {
+    scheduler_add_task(&(struct task_config) { "cmd", TASK_ONCE, TASK_ASAP }, command_task, commands[i]);
+  }
+  while (!finished() && (limit == 0 || host_clock_now() < limit)) {
+    host_scheduler_run_until(host_clock_now() + RUN_STEP);
+  }
+  double elapsed = (double) (clock() - started) / CLOCKS_PER_SEC;
+
+  if (trace_path != NULL) {
+    host_replay_close();
+  }
+  host_dht11_close();
+  if (!host_eeprom_close()) {
+    perror(eeprom_path);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t reads = host_dht11_reads();
+  fprintf(stderr, "%" PRIu64 " s simulated, %lu reads, %lu EEPROM bytes written, %.3f s (%.0f reads/s)\n",
+    host_clock_now() / 1000, (unsigned long) reads, (unsigned long) host_eeprom_bytes_written(),
+    elapsed, elapsed > 0 ? reads / elapsed : 0);
+  return EXIT_SUCCESS;
+}
+
+static void command_task(struct task* task) {
+  host_shell_execute((char*) task->data);
+}
+
+static void usage(const char* name) {
+  fprintf(stderr, "usage: %s [-c shell line]... [-e eeprom.bin] [-t seconds] script|-\n"
+    "       %s [-c shell line]... [-e eeprom.bin] [-t seconds] -r trace.csv|-\n", name, name);
+}
@@ -0,0 +1,36 @@
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "power.h"
+#include "scheduler.h"
+
+// Stand-in for the sleep module. Time on the host only moves from one
+// task to the next, so there is nothing to sleep through and no figure
+// worth reporting; the device's idle task, which runs on every pass of
+// the scheduler loop, would only slow a replay down. A task that runs
+// once a minute and does nothing holds its scheduler slot, so a run
+// that would fill the scheduler on the device fills it here too.
+
+#define IDLE_SLOT_INTERVAL 60000
+
+static void idle_slot_task(struct task* task);
+
+void power_init(void) {
+  struct task_config idle_task_config = { "pwidl", TASK_FOREVER, IDLE_SLOT_INTERVAL };
+  scheduler_add_task(&idle_task_config, idle_slot_task, NULL);
+}
+
+void power_get_stats(struct power_stats* stats) {
+  *stats = (struct power_stats) { 0 };
+}
+
+void power_print_stats(FILE* stream) {
+  fputs("not measured on the host\n\n", stream);
+}
+
+void power_reset_stats(void) {
+}
+
+static void idle_slot_task(struct task* task) {
+}
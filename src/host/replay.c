@@ -0,0 +1,243 @@
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dht11.h"
+#include "event/event.h"
+#include "host.h"
+#include "hum_temp.h"
+#include "log.h"
+
+// Replays a recorded trace through the DHT11 stand-in, so it goes
+// through the whole read, filter and monitor path at host speed. The
+// trace is CSV, one row per recorded reading:
+//
+//   <seconds>,<humidity>,<temperature>[,<truth>]
+//
+// Times need only increase; the first row is time zero of the run.
+// An empty humidity or temperature marks a failed reading. truth is
+// 1 while a real humidity event is in progress and 0 otherwise; a
+// 0 -> 1 step is an event onset, and a row without it carries on the
+// one before. Rows that do not start with a digit
+// are skipped, so a header line is fine.
+//
+// Each read returns the latest row at or before the virtual time. If
+// that row is older than REPLAY_MAX_GAP the recorder had a gap and
+// the read times out.
+//
+// Output, also CSV, in trace time:
+//   <seconds>,truth                      an event onset
+//   <seconds>,alarm,<h 20s>,<h 10min>    a change alarm
+//   <seconds>,detected,<latency>         alarm within
+//                                        REPLAY_MATCH_WINDOW of an onset
+//   <seconds>,missed                     onset with no alarm in time
+//   <seconds>,repeat                     another alarm during a detected
+//                                        event
+//   <seconds>,false                      alarm with no event going on
+// and a summary line at the end.
+
+#define REPLAY_LINE_LENGTH 80
+#define REPLAY_MAX_GAP 10000
+#define REPLAY_MATCH_WINDOW 600000
+
+struct trace_row {
+  uint64_t time;
+  bool valid;
+  bool truth;
+  uint8_t humidity;
+  uint8_t temperature;
+};
+
+struct replay_stats {
+  uint32_t onsets;
+  uint32_t detected;
+  uint32_t missed;
+  uint32_t false_alarms;
+  uint64_t latency_total;
+  uint64_t latency_min;
+  uint64_t latency_max;
+};
+
+static FILE* trace;
+static FILE* output;
+static double trace_start;
+static bool trace_started;
+static uint32_t trace_line;
+static bool trace_truth;
+
+static struct trace_row current;
+static struct trace_row next;
+static bool have_current;
+static bool have_next;
+
+static bool pending_onset;
+static uint64_t onset_time;
+static struct replay_stats stats;
+
+static bool read_row(struct trace_row* row);
+static void take_row(const struct trace_row* row);
+static void expire_onset(uint64_t now);
+static bool on_change(event_t* event);
+static void print_time(uint64_t time);
+static void print_tenths(uint16_t value);
+
+bool host_replay_open(const char* path, FILE* out) {
+  trace = string_eq(path, "-") ? stdin : fopen(path, "r");
+  if (trace == NULL) return false;
+
+  output = out;
+  stats = (struct replay_stats) { .latency_min = UINT64_MAX };
+  have_next = read_row(&next);
+  event_add_listener(EVENT_TYPE_HUM_TEMP, EVENT_DESCRIPTOR_HUM_TEMP_CHANGE, on_change);
+  fprintf(output, "# seconds,event,...\n");
+  return true;
+}
+
+result_t host_replay_frame(uint8_t* data) {
+  uint64_t now = host_clock_now();
+  while (have_next && next.time <= now) {
+    take_row(&next);
+    have_next = read_row(&next);
+  }
+  expire_onset(now);
+
+  if (!have_current || !current.valid || now - current.time > REPLAY_MAX_GAP) {
+    return DHT11_RESULT_FAIL_TIMEOUT;
+  }
+  data[0] = current.humidity;
+  data[2] = current.temperature;
+  data[4] = data[0] + data[2];
+  return DHT11_RESULT_SUCCESS;
+}
+
+bool host_replay_done(void) {
+  return !have_next;
+}
+
+void host_replay_close(void) {
+  expire_onset(UINT64_MAX);
+  if (trace != NULL && trace != stdin) {
+    fclose(trace);
+  }
+  trace = NULL;
+
+  fprintf(output, "# onsets %lu detected %lu missed %lu false %lu",
+    (unsigned long) stats.onsets, (unsigned long) stats.detected,
+    (unsigned long) stats.missed, (unsigned long) stats.false_alarms);
+  if (stats.detected > 0) {
+    fprintf(output, " latency min %.1f mean %.1f max %.1f s",
+      stats.latency_min / 1000.0, stats.latency_total / 1000.0 / stats.detected, stats.latency_max / 1000.0);
+  }
+  fprintf(output, "\n");
+}
+
+static bool read_row(struct trace_row* row) {
+  char line[REPLAY_LINE_LENGTH];
+  while (fgets(line, sizeof(line), trace) != NULL) {
+    trace_line++;
+    if (line[0] < '0' || line[0] > '9') continue;
+
+    char* fields[4] = { line, NULL, NULL, NULL };
+    uint8_t count = 1;
+    for (char* c = line; *c != '\0' && count < ARRAY_SIZE(fields); c++) {
+      if (*c == ',') {
+        *c = '\0';
+        fields[count++] = c + 1;
+      }
+    }
+    if (count < 3) {
+      LOG_ERROR("Trace line %lu has too few fields\n", (unsigned long) trace_line);
+      continue;
+    }
+
+    double seconds = strtod(fields[0], NULL);
+    if (!trace_started) {
+      trace_start = seconds;
+      trace_started = true;
+    }
+    row->time = (seconds - trace_start) * 1000 + 0.5;
+
+    char* end_humidity;
+    char* end_temperature;
+    long humidity = strtol(fields[1], &end_humidity, 10);
+    long temperature = strtol(fields[2], &end_temperature, 10);
+    row->valid = end_humidity != fields[1] && end_temperature != fields[2]
+      && humidity >= 0 && humidity <= UINT8_MAX && temperature >= 0 && temperature <= UINT8_MAX;
+    row->humidity = row->valid ? humidity : 0;
+    row->temperature = row->valid ? temperature : 0;
+    if (count > 3) {
+      trace_truth = atoi(fields[3]) != 0;
+    }
+    row->truth = trace_truth;
+    return true;
+  }
+  return false;
+}
+
+static void take_row(const struct trace_row* row) {
+  bool onset = row->truth && !(have_current && current.truth);
+  current = *row;
+  have_current = true;
+  if (!onset) return;
+
+  // An earlier onset still waiting when the next one starts was missed
+  expire_onset(UINT64_MAX);
+  stats.onsets++;
+  pending_onset = true;
+  onset_time = row->time;
+  print_time(row->time);
+  fprintf(output, ",truth\n");
+}
+
+static void expire_onset(uint64_t now) {
+  if (!pending_onset || now - onset_time <= REPLAY_MATCH_WINDOW) return;
+
+  pending_onset = false;
+  stats.missed++;
+  print_time(onset_time);
+  fprintf(output, ",missed\n");
+}
+
+static bool on_change(event_t* event) {
+  struct hum_temp_change_event* change_event = (struct hum_temp_change_event*) event;
+  uint64_t now = host_clock_now();
+
+  print_time(now);
+  fprintf(output, ",alarm,");
+  print_tenths(change_event->stats.humidity_av_20_sec);
+  fprintf(output, ",");
+  print_tenths(change_event->stats.humidity_av_10_min);
+  fprintf(output, "\n");
+
+  expire_onset(now);
+  print_time(now);
+  if (!pending_onset && current.truth) {
+    fprintf(output, ",repeat\n");
+    return false;
+  }
+  if (!pending_onset) {
+    stats.false_alarms++;
+    fprintf(output, ",false\n");
+    return false;
+  }
+
+  uint64_t latency = now - onset_time;
+  pending_onset = false;
+  stats.detected++;
+  stats.latency_total += latency;
+  if (latency < stats.latency_min) stats.latency_min = latency;
+  if (latency > stats.latency_max) stats.latency_max = latency;
+  fprintf(output, ",detected,%.1f\n", latency / 1000.0);
+  return false;
+}
+
+static void print_time(uint64_t time) {
+  fprintf(output, "%.3f", trace_start + time / 1000.0);
+}
+
+static void print_tenths(uint16_t value) {
+  uint32_t tenths = ((uint32_t) value * 10 + (1 << (HUM_TEMP_FRACTION_BITS - 1))) >> HUM_TEMP_FRACTION_BITS;
+  fprintf(output, "%lu.%lu", (unsigned long) tenths / 10, (unsigned long) tenths % 10);
+}
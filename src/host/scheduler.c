@@ -0,0 +1,83 @@
+
+#include <inttypes.h>
+
+#include "host.h"
+#include "log.h"
+#include "scheduler.h"
+
+struct slot {
+  bool used;
+  uint16_t times;
+  uint16_t interval;
+  uint64_t due;
+  uint32_t order;
+  task_func func;
+  struct task task;
+};
+
+// Same capacity as the device, so a run that would overflow the
+// scheduler there fails here too
+static struct slot slots[SCHEDULER_MAX_TASKS];
+static uint32_t next_order;
+
+static struct slot* next_due(uint64_t until);
+
+uint8_t scheduler_add_task(struct task_config* config, task_func func, void* data) {
+  for (uint8_t id = 0; id < SCHEDULER_MAX_TASKS; id++) {
+    struct slot* slot = &slots[id];
+    if (slot->used) continue;
+
+    slot->used = true;
+    slot->times = config->times;
+    slot->interval = config->interval;
+    slot->due = host_clock_now() + config->interval;
+    slot->order = next_order++;
+    slot->func = func;
+    slot->task = (struct task) { .id = id, .name = config->name, .times_run = 0, .data = data };
+    return id;
+  }
+
+  LOG_ERROR("Scheduler full, dropped task %s\n", config->name);
+  return TASK_NO_TASK;
+}
+
+void scheduler_remove_task(uint8_t id) {
+  if (id < SCHEDULER_MAX_TASKS) {
+    slots[id].used = false;
+  }
+}
+
+void host_scheduler_run_until(uint64_t until) {
+  struct slot* slot;
+  while ((slot = next_due(until)) != NULL) {
+    host_clock_set(slot->due);
+    slot->task.times_run++;
+
+    // The callback gets a copy, as the slot may be freed and reused by
+    // a task it adds
+    struct task task = slot->task;
+    task_func func = slot->func;
+    if (slot->times != TASK_FOREVER && slot->task.times_run >= slot->times) {
+      slot->used = false;
+    } else {
+      slot->due += slot->interval ? slot->interval : 1;
+      slot->order = next_order++;
+    }
+    func(&task);
+  }
+  host_clock_set(until);
+}
+
+// Earliest due first; tasks due together run in the order they were
+// added or last ran
+static struct slot* next_due(uint64_t until) {
+  struct slot* next = NULL;
+  for (uint8_t id = 0; id < SCHEDULER_MAX_TASKS; id++) {
+    struct slot* slot = &slots[id];
+    if (!slot->used || slot->due > until) continue;
+    if (next == NULL || slot->due < next->due || (slot->due == next->due && slot->order < next->order)) {
+      next = slot;
+    }
+  }
+  return next;
+}
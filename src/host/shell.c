@@ -0,0 +1,57 @@
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "host.h"
+#include "shell.h"
+
+struct handler {
+  const char* command;
+  shell_handler_t handler;
+};
+
+static struct handler handlers[SHELL_MAX_HANDLERS];
+static uint8_t handler_count;
+
+void shell_register_handler(const char* command, shell_handler_t handler) {
+  if (handler_count < SHELL_MAX_HANDLERS) {
+    handlers[handler_count++] = (struct handler) { command, handler };
+  }
+}
+
+void shell_printf(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  vfprintf(stdout, format, args);
+  va_end(args);
+}
+
+FILE* shell_get_stream(void) {
+  return stdout;
+}
+
+bool string_eq(const char* a, const char* b) {
+  return strcmp(a, b) == 0;
+}
+
+// Splits the line in place on spaces, like the serial shell does
+void host_shell_execute(char* line) {
+  shell_command_t command = { 0 };
+  char* token = strtok(line, " \t");
+  if (token == NULL) return;
+  command.command = token;
+  while (command.args_count < SHELL_MAX_ARGS && (token = strtok(NULL, " \t")) != NULL) {
+    command.args[command.args_count++] = token;
+  }
+
+  for (uint8_t i = 0; i < handler_count; i++) {
+    if (!string_eq(handlers[i].command, command.command)) continue;
+    if (handlers[i].handler(&command) != SHELL_RESULT_SUCCESS) {
+      printf("? %s\n", command.command);
+    }
+    return;
+  }
+  printf("? %s\n", command.command);
+}
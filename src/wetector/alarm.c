@@ -0,0 +1,69 @@
+#include <inttypes.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#include "alarm.h"
+
+#if F_CPU != ALARM_PATTERN_F_CPU
+#error "res/alarm_patterns.yml is timed for a different F_CPU"
+#endif
+
+// CTC mode, toggling OC2A on compare match, clocked at /64
+#define ALARM_TIMER_MODE _BV(WGM21)
+#define ALARM_TIMER_OUTPUT _BV(COM2A0)
+#define ALARM_TIMER_CLOCK _BV(CS22)
+
+static uint16_t pattern_start;
+static uint16_t pattern_end;
+static uint16_t step;
+static uint8_t matches_left;
+
+static void load_step(void);
+
+void alarm_play(uint8_t pattern) {
+  if (pattern >= ALARM_PATTERN_COUNT) return;
+  TIMSK2 = 0;
+  TCCR2B = 0;
+  pattern_start = pgm_read_word(&alarm_pattern_starts[pattern]);
+  pattern_end = pgm_read_word(&alarm_pattern_starts[pattern + 1]);
+  step = pattern_start;
+  TCCR2A = ALARM_TIMER_MODE;
+  TCNT2 = 0;
+  load_step();
+  TIFR2 = _BV(OCF2A);
+  TIMSK2 = _BV(OCIE2A);
+  TCCR2B = ALARM_TIMER_CLOCK;
+}
+
+void alarm_stop(void) {
+  TIMSK2 = 0;
+  TCCR2B = 0;
+  TCCR2A = 0;
+  PORTB &= ~_BV(PORTB3);
+}
+
+bool alarm_is_playing(void) {
+  return TCCR2B != 0;
+}
+
+// Called just after a compare match, while TCNT2 is still below any
+// new OCR2A, so changing the tone never skips a cycle
+static void load_step(void) {
+  uint8_t matches = pgm_read_byte(&alarm_steps[step].matches);
+  OCR2A = pgm_read_byte(&alarm_steps[step].ocr);
+  if (matches & ALARM_STEP_SILENT) {
+    TCCR2A &= ~ALARM_TIMER_OUTPUT;
+  } else {
+    TCCR2A |= ALARM_TIMER_OUTPUT;
+  }
+  matches_left = matches & ~ALARM_STEP_SILENT;
+}
+
+ISR(TIMER2_COMPA_vect) {
+  if (--matches_left) return;
+  if (++step == pattern_end) {
+    step = pattern_start;
+  }
+  load_step();
+}
@@ -0,0 +1,18 @@
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <inttypes.h>
+
+#include "common.h"
+#include "wetector/alarm_patterns.h"
+
+// Plays one of the ALARM_PATTERN_* tables from res/alarm_patterns.yml
+// on the speaker (OC2A, PB3) until alarm_stop. The Timer2 compare
+// interrupt steps through the table, so no task is involved.
+void alarm_play(uint8_t pattern);
+
+void alarm_stop(void);
+
+bool alarm_is_playing(void);
+
+#endif
@@ -3,8 +3,12 @@
 
 #define EVENT_MAX_SOURCES 5
 #define EVENT_MAX_LISTENERS 6
-#define SCHEDULER_MAX_TASKS 7
+#define SCHEDULER_MAX_TASKS 8
 #define SHELL_CMD_MAX_LENGTH 17
 #define SHELL_MAX_HANDLERS 5
 
+// DHT11 sensors, all on port C, read in turn across the poll interval
+#define HUM_TEMP_SENSORS 1
+#define HUM_TEMP_SENSOR_PINS { GPIO_PIN_0 }
+
 #endif
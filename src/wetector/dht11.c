@@ -1,21 +1,71 @@
 
 #include <stdio.h>
 #include <inttypes.h>
+#include <avr/interrupt.h>
 #include <avr/io.h>
-#include <util/delay.h>
+#include <util/atomic.h>
 
+#include "dht11.h"
 #include "log.h"
 #include "hal/hal.h"
 
-enum DHT11_RESULT {
-  DHT11_RESULT_SUCCESS, DHT11_RESULT_FAIL_START_1, DHT11_RESULT_FAIL_START_2,
-  DHT11_RESULT_FAIL_CHECKSUM
+// Edges are timestamped with the free-running Timer0 counter and
+// caught with the pin-change interrupt group of the sensor's port
+// (PCINT1 for port C).
+#define DHT11_TIMER_COUNT TCNT0
+#define DHT11_TIMER_CLOCK_SELECT (TCCR0B & (_BV(CS02) | _BV(CS01) | _BV(CS00)))
+
+#define DHT11_PCINT_vect PCINT1_vect
+#define DHT11_PCMSK PCMSK1
+#define DHT11_PCIE PCIE1
+#define DHT11_PCIF PCIF1
+
+#define DHT11_FRAME_BYTES 5
+#define DHT11_FRAME_BITS (DHT11_FRAME_BYTES * 8)
+
+#define DHT11_RESPONSE_MIN_US 40
+#define DHT11_RESPONSE_MAX_US 120
+#define DHT11_ZERO_PULSE_US 27
+#define DHT11_ONE_PULSE_US 70
+#define DHT11_PULSE_MAX_US 120
+
+enum dht11_state {
+  DHT11_STATE_IDLE, DHT11_STATE_START, DHT11_STATE_RESPONSE_LOW, DHT11_STATE_RESPONSE_HIGH,
+  DHT11_STATE_DATA, DHT11_STATE_DONE, DHT11_STATE_FAIL
 };
 
+struct dht11_decoder {
+  volatile uint8_t* input_reg;
+  uint8_t pin_mask;
+  uint8_t level;
+  uint8_t last_edge;
+  uint8_t bit;
+  uint8_t response_min;
+  uint8_t response_max;
+  uint8_t pulse_max;
+  uint8_t pulse_min_seen;
+  uint8_t pulse_max_seen;
+  uint8_t zero_width;
+  uint8_t one_width;
+  uint8_t bit_threshold;
+  uint8_t result;
+  uint8_t data[DHT11_FRAME_BYTES];
+  volatile uint8_t state;
+};
+
+static struct dht11_decoder decoder = { .state = DHT11_STATE_IDLE };
+static struct dht11_diagnostics diagnostics;
+
+// Timer prescaler as a shift, indexed by the CSn2:0 clock select bits
+static const uint8_t timer_prescale_shifts[] = { 0, 0, 3, 6, 8, 10, 0, 0 };
+
 static void reset(const struct gpio* gpio, struct gpio_regs* regs) __attribute__((always_inline));
-static result_t send_start(const struct gpio* gpio, struct gpio_regs* regs);
-static uint8_t read_byte(const struct gpio* gpio, struct gpio_regs* regs);
+static uint8_t us_to_ticks(uint16_t us);
+static void disarm(void);
+static void fail(uint8_t result);
+static void classify_bit(uint8_t width);
 static result_t checksum(uint8_t* data);
+static result_t record(result_t result);
 
 void dht11_signal_start(const struct gpio* gpio) {
   struct gpio_regs regs = { 0 };
@@ -25,24 +75,126 @@ void dht11_signal_start(const struct gpio* gpio) {
   *(regs.port_data_reg) &= ~_BV(gpio->pin);
 }
 
-result_t dht11_read(const struct gpio* gpio, uint8_t* data) {
-  result_t result;  
+void dht11_begin_read(const struct gpio* gpio) {
   struct gpio_regs regs = { 0 };
   gpio_port_regs(gpio, &regs);
-  
-  result = send_start(gpio, &regs);
-  if (result != DHT11_RESULT_SUCCESS) return result;
-  
-  for (uint8_t i = 0; i < 5; i++) {
-    data[i] = read_byte(gpio, &regs);
+
+  decoder.input_reg = regs.port_input_reg;
+  decoder.pin_mask = _BV(gpio->pin);
+  decoder.level = decoder.pin_mask;
+  decoder.bit = 0;
+  decoder.response_min = us_to_ticks(DHT11_RESPONSE_MIN_US);
+  decoder.response_max = us_to_ticks(DHT11_RESPONSE_MAX_US);
+  decoder.pulse_max = us_to_ticks(DHT11_PULSE_MAX_US);
+  decoder.pulse_min_seen = UINT8_MAX;
+  decoder.pulse_max_seen = 0;
+  // The class means carry over between reads so the threshold tracks
+  // slow drift; they start from the datasheet pulse widths
+  if (decoder.one_width == 0) {
+    decoder.zero_width = us_to_ticks(DHT11_ZERO_PULSE_US);
+    decoder.one_width = us_to_ticks(DHT11_ONE_PULSE_US);
   }
+  decoder.bit_threshold = (decoder.zero_width + decoder.one_width) >> 1;
+  for (uint8_t i = 0; i < DHT11_FRAME_BYTES; i++) {
+    decoder.data[i] = 0;
+  }
+
+  // Arm before releasing the line: the sensor answers within 20-40us
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    decoder.state = DHT11_STATE_START;
+    DHT11_PCMSK |= decoder.pin_mask;
+    PCIFR = _BV(DHT11_PCIF);
+    PCICR |= _BV(DHT11_PCIE);
+  }
+
+  *(regs.port_data_reg) |= _BV(gpio->pin);
+  *(regs.port_direction_reg) &= ~_BV(gpio->pin);
+}
 
+result_t dht11_end_read(const struct gpio* gpio, uint8_t* data) {
+  struct gpio_regs regs = { 0 };
+  gpio_port_regs(gpio, &regs);
+
+  uint8_t state;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    disarm();
+    state = decoder.state;
+    decoder.state = DHT11_STATE_IDLE;
+  }
   reset(gpio, &regs);
 
-  result = checksum(data);
-  if (result != DHT11_RESULT_SUCCESS) return result;
+  for (uint8_t i = 0; i < DHT11_FRAME_BYTES; i++) {
+    data[i] = decoder.data[i];
+  }
 
-  return DHT11_RESULT_SUCCESS;
+  diagnostics.bits = decoder.bit;
+  diagnostics.pulse_min = decoder.pulse_min_seen;
+  diagnostics.pulse_max = decoder.pulse_max_seen;
+  diagnostics.threshold = decoder.bit_threshold;
+
+  if (state == DHT11_STATE_FAIL) return record(decoder.result);
+  if (state != DHT11_STATE_DONE) return record(DHT11_RESULT_FAIL_TIMEOUT);
+
+  return record(checksum(data));
+}
+
+const struct dht11_diagnostics* dht11_diagnostics(void) {
+  return &diagnostics;
+}
+
+void dht11_reset_diagnostics(void) {
+  diagnostics = (struct dht11_diagnostics) { 0 };
+}
+
+uint16_t dht11_ticks_to_us(uint8_t ticks) {
+  return ((uint32_t) ticks << timer_prescale_shifts[DHT11_TIMER_CLOCK_SELECT]) / (F_CPU / 1000000UL);
+}
+
+ISR(DHT11_PCINT_vect) {
+  uint8_t now = DHT11_TIMER_COUNT;
+  uint8_t level = *(decoder.input_reg) & decoder.pin_mask;
+  if (level == decoder.level) return;
+  decoder.level = level;
+
+  uint8_t width = now - decoder.last_edge;
+  decoder.last_edge = now;
+
+  switch (decoder.state) {
+    case DHT11_STATE_START:
+      if (!level) {
+        decoder.state = DHT11_STATE_RESPONSE_LOW;
+      }
+      break;
+    case DHT11_STATE_RESPONSE_LOW:
+      if (width < decoder.response_min || width > decoder.response_max) {
+        fail(DHT11_RESULT_FAIL_START_1);
+      } else {
+        decoder.state = DHT11_STATE_RESPONSE_HIGH;
+      }
+      break;
+    case DHT11_STATE_RESPONSE_HIGH:
+      if (width < decoder.response_min || width > decoder.response_max) {
+        fail(DHT11_RESULT_FAIL_START_2);
+      } else {
+        decoder.state = DHT11_STATE_DATA;
+      }
+      break;
+    case DHT11_STATE_DATA:
+      // A pulse longer than any valid low gap or high bit means we lost an edge
+      if (width > decoder.pulse_max) {
+        fail(DHT11_RESULT_FAIL_TIMEOUT);
+      } else if (!level) {
+        // A bit is the width of the high pulse, measured on its falling edge
+        classify_bit(width);
+        if (++decoder.bit == DHT11_FRAME_BITS) {
+          decoder.state = DHT11_STATE_DONE;
+          disarm();
+        }
+      }
+      break;
+    default:
+      break;
+  }
 }
 
 static void reset(const struct gpio* gpio, struct gpio_regs* regs) {
@@ -50,41 +202,43 @@ static void reset(const struct gpio* gpio, struct gpio_regs* regs) {
   *(regs->port_data_reg) |= _BV(gpio->pin);
 }
 
-static result_t send_start(const struct gpio* gpio, struct gpio_regs* regs) {
-  *(regs->port_data_reg) |= _BV(gpio->pin);
-  _delay_us(40);
-  *(regs->port_direction_reg) &= ~_BV(gpio->pin);
-  _delay_us(40);
-  
-  uint8_t current_state;
-  current_state = *(regs->port_input_reg) & _BV(gpio->pin);
-  if (current_state) {
-    return DHT11_RESULT_FAIL_START_1;
-  }
+static uint8_t us_to_ticks(uint16_t us) {
+  uint32_t ticks = ((uint32_t) us * (F_CPU / 1000000UL)) >> timer_prescale_shifts[DHT11_TIMER_CLOCK_SELECT];
+  return ticks > UINT8_MAX ? UINT8_MAX : ticks;
+}
 
-  _delay_us(80);
-  current_state = *(regs->port_input_reg) & _BV(gpio->pin);
-  if (!current_state) {
-    return DHT11_RESULT_FAIL_START_2;
+static void disarm(void) {
+  DHT11_PCMSK &= ~decoder.pin_mask;
+  if (!DHT11_PCMSK) {
+    PCICR &= ~_BV(DHT11_PCIE);
   }
-  
-  _delay_us(80);
+}
 
-  return DHT11_RESULT_SUCCESS;
+static void fail(uint8_t result) {
+  decoder.result = result;
+  decoder.state = DHT11_STATE_FAIL;
+  disarm();
+}
+
+static void classify_bit(uint8_t width) {
+  if (width < decoder.pulse_min_seen) decoder.pulse_min_seen = width;
+  if (width > decoder.pulse_max_seen) decoder.pulse_max_seen = width;
+
+  // Each class mean moves a quarter of the way towards every pulse it
+  // wins, and the threshold sits halfway between the two means
+  if (width > decoder.bit_threshold) {
+    decoder.data[decoder.bit >> 3] |= (1 << (7 - (decoder.bit & 7)));
+    decoder.one_width += ((int16_t) width - decoder.one_width) >> 2;
+  } else {
+    decoder.zero_width += ((int16_t) width - decoder.zero_width) >> 2;
+  }
+  decoder.bit_threshold = (decoder.zero_width + decoder.one_width) >> 1;
 }
 
-static uint8_t read_byte(const struct gpio* gpio, struct gpio_regs* regs) {
-  uint8_t result = 0;
-  uint8_t wait_counter;
-  for(uint8_t i = 0; i < 8; i++) {
-    wait_counter = 0;
-    while (!(*(regs->port_input_reg) & _BV(gpio->pin)) && ++wait_counter < 200);
-    _delay_us(30);
-    if (*(regs->port_input_reg) & _BV(gpio->pin)) {
-      result |= (1 << (7 - i));
-    }
-    wait_counter = 0;
-    while ((*(regs->port_input_reg) & _BV(gpio->pin)) && ++wait_counter < 200);
+static result_t record(result_t result) {
+  diagnostics.result = result;
+  if (diagnostics.results[result] < UINT16_MAX) {
+    diagnostics.results[result]++;
   }
   return result;
 }
@@ -6,8 +6,35 @@
 #include "common.h"
 #include "hal/hal.h"
 
-result_t dht11_read(const struct gpio* gpio, uint8_t* data);
+// Upper bound in ms on the sensor's response plus its 40 data bits
+#define DHT11_FRAME_TIME 6
+
+enum DHT11_RESULT {
+  DHT11_RESULT_SUCCESS, DHT11_RESULT_FAIL_START_1, DHT11_RESULT_FAIL_START_2,
+  DHT11_RESULT_FAIL_CHECKSUM, DHT11_RESULT_FAIL_TIMEOUT, DHT11_RESULT_COUNT
+};
+
+// Timing of the most recent read, in decoder timer ticks (see
+// dht11_ticks_to_us), plus a running count of each DHT11_RESULT_*
+struct dht11_diagnostics {
+  uint8_t result;
+  uint8_t bits;
+  uint8_t pulse_min;
+  uint8_t pulse_max;
+  uint8_t threshold;
+  uint16_t results[DHT11_RESULT_COUNT];
+};
 
 void dht11_signal_start(const struct gpio* gpio);
 
+void dht11_begin_read(const struct gpio* gpio);
+
+result_t dht11_end_read(const struct gpio* gpio, uint8_t* data);
+
+const struct dht11_diagnostics* dht11_diagnostics(void);
+
+void dht11_reset_diagnostics(void);
+
+uint16_t dht11_ticks_to_us(uint8_t ticks);
+
 #endif
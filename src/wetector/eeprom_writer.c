@@ -0,0 +1,61 @@
+
+#include <inttypes.h>
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+#include "eeprom_writer.h"
+
+static uint8_t buffer[EEPROM_WRITER_BUFFER_SIZE];
+static uint16_t address;
+static uint8_t length;
+static volatile uint8_t pos;
+static volatile bool busy;
+
+uint8_t eeprom_writer_write(uint16_t write_address, const void* data, uint8_t write_length) {
+  if (busy) return 0;
+  if (write_length > EEPROM_WRITER_BUFFER_SIZE) {
+    write_length = EEPROM_WRITER_BUFFER_SIZE;
+  }
+
+  const uint8_t* bytes = (const uint8_t*) data;
+  for (uint8_t i = 0; i < write_length; i++) {
+    buffer[i] = bytes[i];
+  }
+  address = write_address;
+  length = write_length;
+  pos = 0;
+  busy = true;
+
+  EECR |= _BV(EERIE);
+  return write_length;
+}
+
+bool eeprom_writer_busy(void) {
+  return busy;
+}
+
+void eeprom_writer_wait(void) {
+  while (busy);
+  eeprom_busy_wait();
+}
+
+// Fires whenever EEPE is clear, so reads need no busy wait here
+ISR(EE_READY_vect) {
+  while (pos < length) {
+    uint16_t byte_address = address + pos;
+    uint8_t value = buffer[pos++];
+
+    EEAR = byte_address;
+    EECR |= _BV(EERE);
+    if (EEDR == value) continue;
+
+    EEDR = value;
+    EECR |= _BV(EEMPE);
+    EECR |= _BV(EEPE);
+    return;
+  }
+
+  EECR &= ~_BV(EERIE);
+  busy = false;
+}
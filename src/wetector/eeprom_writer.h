@@ -0,0 +1,19 @@
+#ifndef EEPROM_WRITER_H
+#define EEPROM_WRITER_H
+
+#include <inttypes.h>
+
+#include "common.h"
+
+#define EEPROM_WRITER_BUFFER_SIZE 16
+
+// Copies data and writes it to EEPROM from the EE_READY interrupt, one
+// byte per ready period, skipping bytes that already hold the value.
+// Only one write is in flight at a time: check eeprom_writer_busy first.
+uint8_t eeprom_writer_write(uint16_t address, const void* data, uint8_t length);
+
+bool eeprom_writer_busy(void);
+
+void eeprom_writer_wait(void);
+
+#endif
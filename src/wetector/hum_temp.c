@@ -6,39 +6,238 @@
 #include "dht11.h"
 #include "hum_temp.h"
 #include "log.h"
+#include "print.h"
 #include "wetector/pgm_strings.h"
 #include "hal/hal.h"
+#include "rollup_log.h"
 #include "sample_buffer.h"
-
-#define EVENT_TYPE_HUM_TEMP 0x06
-#define EVENT_DESCRIPTOR_HUM_TEMP_READING 0x00
-#define EVENT_DESCRIPTOR_HUM_TEMP_CHANGE 0x01
-#define EVENT_DESCRIPTOR_HUM_TEMP_CALIBRATE 0x02
+#include "sample_log.h"
+#include "snapshot.h"
+#include "task_profile.h"
+#include "telemetry.h"
 
 #define CALIBRATE_SAMPLES 10
 
+// The buffers take one sample per DHT11_POLL_INTERVAL whatever the
+// poll rate (see on_hum_temp_reading); the DHT11 itself can be read
+// every DHT11_MIN_POLL_INTERVAL at most
 #define DHT11_POLL_INTERVAL 2000
+#define DHT11_MIN_POLL_INTERVAL 1000
+#define DHT11_START_TIME 18
+
+// The sensors in HUM_TEMP_SENSOR_PINS share the one decoder, so they
+// are read in turn: the collector runs once per slot and reads the
+// next sensor, which still reads each sensor every DHT11_POLL_INTERVAL
+#define SENSOR_SLOT (DHT11_POLL_INTERVAL / HUM_TEMP_SENSORS)
+
+// A failed read is retried after 200 ms, then 400 ms, which still ends
+// well inside the poll interval
+#define READ_RETRIES 2
+#define READ_RETRY_BACKOFF 200
+
+// A read with both retries has to be over before the next sensor's
+// start signal
+#define READ_WORST_CASE ((READ_RETRIES + 1) * (DHT11_START_TIME + DHT11_FRAME_TIME) \
+  + (READ_RETRY_BACKOFF << READ_RETRIES) - READ_RETRY_BACKOFF)
+#if READ_WORST_CASE > SENSOR_SLOT
+#error "Too many sensors in HUM_TEMP_SENSOR_PINS for their reads to fit the poll interval"
+#endif
+
+// Adaptive polling: before each round of reads the collector looks at
+// the variance of the 20 second buffers. Past POLL_VOLATILE_VARIANCE it
+// polls as fast as the sensors and their slots allow; once every
+// variance has stayed under POLL_CALM_VARIANCE for POLL_CALM_TIME ms it
+// doubles the interval, up to POLL_MAX_INTERVAL, and in between it
+// polls no slower than DHT11_POLL_INTERVAL. Variances are in %RH^2 or
+// C^2 with HUM_TEMP_FRACTION_BITS; the calm bar lets through the DHT11
+// flickering between two counts.
+//
+// The variance only shows a step after the spike filter has let it
+// through, a slow reading or two late, so a raw reading POLL_STEP
+// counts or more from the sensor's last one, or humidity that far from
+// its EWMA, counts as volatile too. A step read at the end of a round
+// brings the next round in at once.
+#define POLL_VOLATILE_VARIANCE (2 << HUM_TEMP_FRACTION_BITS)
+#define POLL_CALM_VARIANCE (1 << (HUM_TEMP_FRACTION_BITS - 1))
+#define POLL_STEP 3
+#define POLL_CALM_TIME 20000
+#define POLL_MAX_INTERVAL 8000
+
+#if HUM_TEMP_SENSORS * READ_WORST_CASE <= DHT11_MIN_POLL_INTERVAL
+#define POLL_MIN_INTERVAL DHT11_MIN_POLL_INTERVAL
+#else
+#define POLL_MIN_INTERVAL DHT11_POLL_INTERVAL
+#endif
+
+// One log entry takes about 8 EEPROM write periods of 3.4 ms
+#define SAVE_INTERVAL 10
+
+// Save on our own every 5 minutes of new windows so a warm start after
+// a reset finds a recent snapshot
+#define AUTOSAVE_WINDOWS 15
+
+// The first reading after a warm start has to be this close to the
+// restored 20 second mean, or the snapshot is treated as stale
+#define WARM_START_HUMIDITY_TOLERANCE 5
+#define WARM_START_TEMPERATURE_TOLERANCE 3
+
+// Change detection compares a fast EWMA of humidity against the 10
+// minute mean on every reading. The alarm fires once the difference
+// exceeds the threshold and rearms when it falls back below threshold
+// minus hysteresis. Both are in whole %RH. The EWMA takes one step of
+// HUMIDITY_EWMA_SHIFT per second a reading stands for, which comes to
+// much the same as a step of one less per DHT11_POLL_INTERVAL.
+#define HUMIDITY_CHANGE_THRESHOLD 10
+#define HUMIDITY_CHANGE_HYSTERESIS 3
+#define HUMIDITY_EWMA_SHIFT 3
+
+// Every completed window folds into its sensor's rollup for the hour
+// of device_seconds it completed in. The first window of a new hour
+// sends the old hour to the rollup log and folds it into the day's,
+// and the first of a new day sends the day.
+#define ROLLUP_HOUR_SECONDS 3600UL
+#define ROLLUP_HOURS_PER_DAY 24
+
+// ht hr and ht dy print this many records a page
+#define ROLLUP_PAGE_RECORDS 8
 
-static struct gpio sensor_gpio = { .port  = GPIO_PORT_C, .pin = GPIO_PIN_0 };
+// Finished hours and days queue for the "htru" task, which appends one
+// a run once the EEPROM writer is free, so a window that closes while
+// a save is writing never waits for it. A sensor queues at most an hour
+// and a day at a time; should a record find the queue full, which
+// takes the writer being stuck for an hour, it is dropped.
+#define ROLLUP_QUEUE_SIZE (2 * HUM_TEMP_SENSORS)
+#define ROLLUP_WRITE_INTERVAL 10
+
+// ht dmp prints from a task, DUMP_SAMPLES_PER_RUN samples a run, so a
+// slow UART doesn't hold up the collector and monitor
+#define DUMP_INTERVAL 10
+#define DUMP_SAMPLES_PER_RUN 10
+#define DUMP_PARTS 6
+
+#define WHOLE(VALUE) ((VALUE) >> HUM_TEMP_FRACTION_BITS)
+#define TENTHS(VALUE) ((((VALUE) & ((1 << HUM_TEMP_FRACTION_BITS) - 1)) * 10) >> HUM_TEMP_FRACTION_BITS)
 
-uint8_t monitor_task_id;
 uint8_t collector_task_id;
+static uint8_t save_task_id = TASK_NO_TASK;
+static uint8_t dump_task_id = TASK_NO_TASK;
+static uint8_t rollup_task_id = TASK_NO_TASK;
+
+SAMPLE_BUFFER_DEFINE(10)
+BUCKET_BUFFER_DEFINE(30, 10)
+DELTA_BUFFER_DEFINE(160)
+
+// An hour or day being rolled up from windows: the lowest and highest
+// window mean and the sums behind the overall mean, per channel, and
+// the hour or day number it covers. No samples means empty.
+struct rollup {
+  uint16_t period;
+  uint16_t samples;
+  uint32_t sums[SAMPLE_LOG_CHANNELS];
+  uint8_t min[SAMPLE_LOG_CHANNELS];
+  uint8_t max[SAMPLE_LOG_CHANNELS];
+};
+
+// Everything kept for one sensor. The 10 minute history is 30 buckets
+// of 20 second window sums rolled up from the 20 second buffer, not
+// 300 raw samples. The raw samples go into the delta coded histories,
+// which hold about the same 10 minutes in 160 bytes each while the
+// readings are steady, and less while they jump about. They are RAM
+// the buckets had freed: a channel's buckets and history come to about
+// 240 bytes against the 300 its raw buffer took, but the two add some
+// 360 bytes to every sensor, which with the buckets alone would have
+// paid for another sensor.
+struct hum_temp_sensor {
+  struct gpio gpio;
+
+  struct sample_buffer_10 humidity_20_sec_buffer;
+  struct bucket_buffer_30 humidity_10_min_buffer;
+  struct delta_buffer_160 humidity_history;
+  struct sample_buffer_10 temperature_20_sec_buffer;
+  struct bucket_buffer_30 temperature_10_min_buffer;
+  struct delta_buffer_160 temperature_history;
+
+  // Readings since the last sample went into the buffers, summed with
+  // the seconds each stands for as their weight, and the ms they cover
+  uint16_t slot_humidity;
+  uint16_t slot_temperature;
+  uint8_t slot_weight;
+  uint16_t slot_time;
+
+  // Windows rolled up since the last save, appended to the log by the next one
+  uint8_t unsaved_windows;
+  bool verify_warm_start;
+
+  // The last two good readings, for the median-of-3 spike filter
+  struct hum_temp_reading recent_readings[2];
+  uint8_t recent_count;
+
+  bool change_alarmed;
+  uint16_t humidity_ewma;
 
-static uint8_t humidity_20_sec_samples[10];
-static struct sample_buffer humidity_20_sec_buffer;
-static uint8_t humidity_10_min_samples[300];
-static struct sample_buffer humidity_10_min_buffer;
+  struct rollup hour_rollup;
+  struct rollup day_rollup;
+};
+
+// The build reports RAM per sensor from the sizes of these two
+static const uint8_t hum_temp_sensor_pins[] PROGMEM = HUM_TEMP_SENSOR_PINS;
+static struct hum_temp_sensor hum_temp_sensors[HUM_TEMP_SENSORS];
+
+_Static_assert(ARRAY_SIZE(hum_temp_sensor_pins) == HUM_TEMP_SENSORS, "HUM_TEMP_SENSOR_PINS needs HUM_TEMP_SENSORS pins");
+// Replays and snapshots count log entries in a byte
+_Static_assert(HUM_TEMP_SENSORS * 30 <= UINT8_MAX, "Too many sensors for a byte of log entries");
+
+// The sensor the collector or calibration reads next, how often each
+// sensor is read and how long the buffers have been calm for
+static uint8_t next_sensor;
+static uint16_t poll_interval = DHT11_POLL_INTERVAL;
+static uint16_t calm_time;
+static bool step_seen;
+
+static bool save_snapshot_written;
+
+static uint8_t read_attempt;
 
-static uint8_t temperature_20_sec_samples[10];
-static struct sample_buffer temperature_20_sec_buffer;
-static uint8_t temperature_10_min_samples[300];
-static struct sample_buffer temperature_10_min_buffer;
+static struct task_profile calibrate_profile;
+static struct task_profile calibrate_complete_profile;
+static struct task_profile collector_profile;
+static struct task_profile read_profile;
+static struct task_profile complete_read_profile;
+static struct task_profile retry_read_profile;
+static struct task_profile save_profile;
+static struct task_profile dump_profile;
+static struct task_profile rollup_profile;
 
-static struct sample_buffer* sample_buffers[4] = { 
-  &humidity_20_sec_buffer, &humidity_10_min_buffer,
-  &temperature_20_sec_buffer, &temperature_10_min_buffer
+struct queued_rollup {
+  uint8_t kind;
+  struct rollup_record record;
 };
 
+static struct queued_rollup rollup_queue[ROLLUP_QUEUE_SIZE];
+static uint8_t rollup_queue_head;
+static uint8_t rollup_queue_count;
+
+// What a dump prints, all taken when it starts: copies of the sensor's
+// 20 second buffers, which a reading can turn over in a few seconds,
+// and cursors over the 10 minute buckets, which keep the heads a push
+// would overwrite, and over the raw histories. The histories are too
+// big to copy, so any of their oldest samples pushed out before their
+// turn print as "..". Also the part being printed.
+static struct sample_buffer_10 dump_buffers[2];
+static struct sample_cursor dump_buffer_cursors[2];
+static struct bucket_cursor dump_bucket_cursors[2];
+static struct delta_cursor dump_history_cursors[2];
+static struct hum_temp_sensor* dump_sensor;
+static uint8_t dump_part;
+static FILE* dump_stream;
+
+static bool monitoring;
+static int16_t change_threshold = HUMIDITY_CHANGE_THRESHOLD << HUM_TEMP_FRACTION_BITS;
+static int16_t change_rearm = (HUMIDITY_CHANGE_THRESHOLD - HUMIDITY_CHANGE_HYSTERESIS) << HUM_TEMP_FRACTION_BITS;
+
+// Seconds of sampling, carried over in snapshots across restarts
+static uint32_t device_seconds;
+
 static struct hum_temp_read_event current_read_event = { 
   .super.type = EVENT_TYPE_HUM_TEMP,
   .super.descriptor = EVENT_DESCRIPTOR_HUM_TEMP_READING
@@ -47,6 +246,14 @@ static struct hum_temp_change_event current_change_event = {
   .super.type = EVENT_TYPE_HUM_TEMP,
   .super.descriptor = EVENT_DESCRIPTOR_HUM_TEMP_CHANGE
 };
+static struct hum_temp_save_event current_save_event = {
+  .super.type = EVENT_TYPE_HUM_TEMP,
+  .super.descriptor = EVENT_DESCRIPTOR_HUM_TEMP_SAVE
+};
+static struct event current_stale_event = {
+  .type = EVENT_TYPE_HUM_TEMP,
+  .descriptor = EVENT_DESCRIPTOR_HUM_TEMP_STALE
+};
 static struct event current_calibrate_event = {
   .type = EVENT_TYPE_HUM_TEMP,
   .descriptor = EVENT_DESCRIPTOR_HUM_TEMP_CALIBRATE
@@ -55,182 +262,832 @@ static struct event current_calibrate_event = {
 static void calibrate_task(struct task* task);
 static void calibrate_complete_task(struct task* task);
 static void collector_task(struct task* task);
-static void monitor_task(struct task* task);
+static void adapt_poll_interval(void);
+static bool reading_stepped(struct hum_temp_sensor* sensor, struct hum_temp_reading reading);
+static uint16_t buffer_variance(void);
+static void detect_change(struct hum_temp_sensor* sensor, uint8_t humidity, uint8_t seconds);
+static void save_task(struct task* task);
+static void dump_task(struct task* task);
+static bool dump_next(void);
+static void print_dump_header(uint8_t part);
+static void start_read_attempt(struct task* task);
+static void hum_temp_begin_read(struct task* task);
 static void hum_temp_complete_read(struct task* task);
 static bool on_hum_temp_reading(event_t* event);
+static void push_slots(struct hum_temp_sensor* sensor);
+static void clear_slot(struct hum_temp_sensor* sensor);
+static void roll_up_window(struct hum_temp_sensor* sensor);
+static void merge_rollup(struct rollup* into, const struct rollup* from);
+static void write_rollup(uint8_t kind, uint8_t sensor, const struct rollup* rollup);
+static void rollup_task(struct task* task);
+static void on_log_entry(const struct sample_log_entry* entry);
+static void reset_buffers(struct hum_temp_sensor* sensor);
+static bool warm_start_agrees(struct hum_temp_sensor* sensor, struct hum_temp_reading reading);
+static struct hum_temp_reading filter_spikes(struct hum_temp_sensor* sensor, struct hum_temp_reading reading);
+static uint8_t median_of_3(uint8_t a, uint8_t b, uint8_t c);
+static uint8_t take_next_sensor(void);
+static const char* channel_label(char channel, uint8_t sensor);
 
 void hum_temp_init() {
-  sample_buffer_init(&humidity_20_sec_buffer, humidity_20_sec_samples, ARRAY_SIZE(humidity_20_sec_samples));
-  sample_buffer_init(&humidity_10_min_buffer, humidity_10_min_samples, ARRAY_SIZE(humidity_10_min_samples));
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    struct hum_temp_sensor* sensor = &hum_temp_sensors[i];
+    sensor->gpio = (struct gpio) { .port = GPIO_PORT_C, .pin = pgm_read_byte(&hum_temp_sensor_pins[i]) };
+
+    sample_buffer_10_init(&sensor->humidity_20_sec_buffer);
+    bucket_buffer_30_init(&sensor->humidity_10_min_buffer);
+    delta_buffer_160_init(&sensor->humidity_history);
+
+    sample_buffer_10_init(&sensor->temperature_20_sec_buffer);
+    bucket_buffer_30_init(&sensor->temperature_10_min_buffer);
+    delta_buffer_160_init(&sensor->temperature_history);
+  }
+
+  sample_log_init();
+  rollup_log_init();
+
+  struct snapshot snapshot;
+  if (snapshot_read(&snapshot)) {
+    device_seconds = snapshot.saved_at;
+  }
+}
+
+// Restores the buffers from the snapshot left by the last save. Returns
+// false, leaving the buffers empty, unless the snapshot is intact, is
+// the last thing written to the log and its whole run replays; the
+// caller then calibrates instead. After a warm start the first good
+// reading is checked against the restored history and on_stale fires
+// if they disagree.
+bool hum_temp_warm_start(event_handler on_stale) {
+  struct snapshot snapshot;
+  uint16_t head_seq;
+  if (!snapshot_read(&snapshot) || !sample_log_head_seq(&head_seq) || head_seq != snapshot.head_seq) {
+    return false;
+  }
 
-  sample_buffer_init(&temperature_20_sec_buffer, temperature_20_sec_samples, ARRAY_SIZE(temperature_20_sec_samples));
-  sample_buffer_init(&temperature_10_min_buffer, temperature_10_min_samples, ARRAY_SIZE(temperature_10_min_samples));
+  uint8_t expected = snapshot.windows;
+  if (expected > HUM_TEMP_SENSORS * ARRAY_SIZE(hum_temp_sensors[0].humidity_10_min_buffer.buckets)) {
+    expected = HUM_TEMP_SENSORS * ARRAY_SIZE(hum_temp_sensors[0].humidity_10_min_buffer.buckets);
+  }
+  if (expected == 0 || hum_temp_load() != expected * sizeof(struct sample_log_entry)) {
+    for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+      reset_buffers(&hum_temp_sensors[i]);
+    }
+    return false;
+  }
+
+  LOG_INFO("Warm start from snapshot saved at %lu s\n", snapshot.saved_at);
+  event_add_listener(EVENT_TYPE_HUM_TEMP, EVENT_DESCRIPTOR_HUM_TEMP_STALE, on_stale);
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    hum_temp_sensors[i].verify_warm_start = true;
+  }
+  return true;
 }
 
 void hum_temp_calibrate(event_handler on_complete) {
   event_add_listener(EVENT_TYPE_HUM_TEMP, EVENT_DESCRIPTOR_HUM_TEMP_CALIBRATE, on_complete);
-  struct task_config calibrate_task_config = { "htcal", CALIBRATE_SAMPLES, DHT11_POLL_INTERVAL };
-	scheduler_add_task(&calibrate_task_config, calibrate_task, NULL); 
+  next_sensor = 0;
+  poll_interval = DHT11_POLL_INTERVAL;
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    clear_slot(&hum_temp_sensors[i]);
+  }
+  struct task_config calibrate_task_config = { "htcal", CALIBRATE_SAMPLES * HUM_TEMP_SENSORS, SENSOR_SLOT };
+	task_profile_add_task(&calibrate_profile, &calibrate_task_config, calibrate_task, NULL); 
 }
 
 static void calibrate_task(struct task* task) {
-  hum_temp_read(on_hum_temp_reading);
-  if (task->times_run == CALIBRATE_SAMPLES) {
-    struct task_config calibrate_task_config = { "htcal", TASK_ONCE, TASK_ASAP };
-    scheduler_add_task(&calibrate_task_config, calibrate_complete_task, NULL);     
+  hum_temp_read(take_next_sensor(), on_hum_temp_reading);
+  if (task->times_run == CALIBRATE_SAMPLES * HUM_TEMP_SENSORS) {
+    struct task_config calibrate_task_config = { "htcfn", TASK_ONCE, TASK_ASAP };
+    task_profile_add_task(&calibrate_complete_profile, &calibrate_task_config, calibrate_complete_task, NULL);     
   }
 }
 
 static void calibrate_complete_task(struct task* task) {
-  struct hum_temp_stats current_stats = hum_temp_current_stats();
+  for (uint8_t s = 0; s < HUM_TEMP_SENSORS; s++) {
+    struct hum_temp_sensor* sensor = &hum_temp_sensors[s];
+    uint8_t humidity = HUM_TEMP_ROUND(sensor->humidity_20_sec_buffer.super.mean);
+    uint8_t temperature = HUM_TEMP_ROUND(sensor->temperature_20_sec_buffer.super.mean);
 
-  for (uint16_t i = 0; i < humidity_20_sec_buffer.size; i++) {
-    push_sample(&humidity_20_sec_buffer, current_stats.humidity_av_20_sec);
-  }
-  for (uint16_t i = 0; i < humidity_10_min_buffer.size; i++) {
-    push_sample(&humidity_10_min_buffer, current_stats.humidity_av_20_sec);
-  }
-  for (uint16_t i = 0; i < temperature_20_sec_buffer.size; i++) {
-    push_sample(&temperature_20_sec_buffer, current_stats.temperature_av_20_sec);
-  }
-  for (uint16_t i = 0; i < temperature_10_min_buffer.size; i++) {
-    push_sample(&temperature_10_min_buffer, current_stats.temperature_av_20_sec);
+    for (uint16_t i = 0; i < ARRAY_SIZE(sensor->humidity_20_sec_buffer.samples); i++) {
+      sample_buffer_10_push(&sensor->humidity_20_sec_buffer, humidity);
+    }
+    for (uint16_t i = 0; i < ARRAY_SIZE(sensor->humidity_10_min_buffer.buckets); i++) {
+      bucket_buffer_30_push(&sensor->humidity_10_min_buffer, humidity * sensor->humidity_10_min_buffer.super.window);
+    }
+    for (uint16_t i = 0; i < ARRAY_SIZE(sensor->temperature_20_sec_buffer.samples); i++) {
+      sample_buffer_10_push(&sensor->temperature_20_sec_buffer, temperature);
+    }
+    for (uint16_t i = 0; i < ARRAY_SIZE(sensor->temperature_10_min_buffer.buckets); i++) {
+      bucket_buffer_30_push(&sensor->temperature_10_min_buffer, temperature * sensor->temperature_10_min_buffer.super.window);
+    }
   }
   
   event_fire_event(&current_calibrate_event);
 }
 
 void hum_temp_start_collector() {
-  struct task_config collector_task_config = { "htcol", TASK_FOREVER, DHT11_POLL_INTERVAL };
-	collector_task_id = scheduler_add_task(&collector_task_config, collector_task, NULL);   
+  next_sensor = 0;
+  poll_interval = DHT11_POLL_INTERVAL;
+  calm_time = 0;
+  step_seen = false;
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    clear_slot(&hum_temp_sensors[i]);
+  }
+  struct task_config collector_task_config = { "htcol", TASK_FOREVER, SENSOR_SLOT };
+	collector_task_id = task_profile_add_task(&collector_profile, &collector_task_config, collector_task, NULL);   
 }
 
 void hum_temp_stop_collector() {
-	scheduler_remove_task(collector_task_id);
+	task_profile_remove_task(&collector_profile, collector_task_id);
 }
 
 void hum_temp_start_monitor(event_handler on_change) {
-  struct task_config monitor_task_config = { "htmon", TASK_FOREVER, DHT11_POLL_INTERVAL * 10 };
-	monitor_task_id = scheduler_add_task(&monitor_task_config, monitor_task, NULL);
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    hum_temp_sensors[i].humidity_ewma = hum_temp_sensors[i].humidity_20_sec_buffer.super.mean;
+    hum_temp_sensors[i].change_alarmed = false;
+  }
+  monitoring = true;
   event_add_listener(EVENT_TYPE_HUM_TEMP, EVENT_DESCRIPTOR_HUM_TEMP_CHANGE, on_change);
 }
 
 void hum_temp_stop_monitor() {
-	scheduler_remove_task(monitor_task_id);   
+  monitoring = false;
 }
 
-static void monitor_task(struct task* task) {
-  struct hum_temp_stats stats = hum_temp_current_stats();
-  int8_t humidity_change = stats.humidity_av_20_sec - stats.humidity_av_10_min;
-  LOG_INFO("Humidity difference: %i\n", humidity_change);
-  if (humidity_change > 10) {
-    LOG_INFO("Humidity difference beyond threshold: %i\n", humidity_change);
-    current_change_event.stats = stats;
+// Past 100 %RH a threshold can never be met, and 128 or more would
+// overflow the fixed point compare
+bool hum_temp_set_change_threshold(uint8_t threshold, uint8_t hysteresis) {
+  if (threshold > HUM_TEMP_MAX_CHANGE_THRESHOLD) return false;
+  if (hysteresis > threshold) {
+    hysteresis = threshold;
+  }
+  change_threshold = (int16_t) threshold << HUM_TEMP_FRACTION_BITS;
+  change_rearm = (int16_t) (threshold - hysteresis) << HUM_TEMP_FRACTION_BITS;
+  return true;
+}
+
+// O(1) per reading: one shift-and-add for the EWMA and a compare
+// against the cached 10 minute mean
+static void detect_change(struct hum_temp_sensor* sensor, uint8_t humidity, uint8_t seconds) {
+  for (uint8_t i = 0; i < seconds; i++) {
+    sensor->humidity_ewma += ((int32_t) ((uint16_t) humidity << HUM_TEMP_FRACTION_BITS) - sensor->humidity_ewma) >> HUMIDITY_EWMA_SHIFT;
+  }
+  int16_t humidity_change = sensor->humidity_ewma - sensor->humidity_10_min_buffer.super.mean;
+
+  if (sensor->change_alarmed) {
+    if (humidity_change < change_rearm) {
+      LOG_INFO("Humidity difference back within threshold: %i\n", humidity_change >> HUM_TEMP_FRACTION_BITS);
+      sensor->change_alarmed = false;
+    }
+  } else if (humidity_change > change_threshold) {
+    LOG_INFO("Humidity difference beyond threshold: %i\n", humidity_change >> HUM_TEMP_FRACTION_BITS);
+    sensor->change_alarmed = true;
+    current_change_event.sensor = sensor - hum_temp_sensors;
+    current_change_event.stats = hum_temp_current_stats(current_change_event.sensor);
     event_fire_event((event_t*) &current_change_event);
   }
 }
 
 static void collector_task(struct task* task) {
-  hum_temp_read(on_hum_temp_reading);
+  if (next_sensor == 0) {
+    adapt_poll_interval();
+  }
+  hum_temp_read(take_next_sensor(), on_hum_temp_reading);
+}
+
+// Picks the interval for the coming round of reads. It only changes
+// while no sensor is part way into a sample, so every reading so far
+// has gone into the buffers with the weight it was read at.
+static void adapt_poll_interval(void) {
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    if (hum_temp_sensors[i].slot_time != 0) return;
+  }
+
+  uint16_t variance = buffer_variance();
+  uint16_t interval = poll_interval;
+  if (step_seen || variance > POLL_VOLATILE_VARIANCE) {
+    interval = POLL_MIN_INTERVAL;
+    calm_time = 0;
+    step_seen = false;
+  } else if (variance < POLL_CALM_VARIANCE) {
+    calm_time += poll_interval;
+    if (calm_time >= POLL_CALM_TIME && interval < POLL_MAX_INTERVAL) {
+      interval <<= 1;
+      calm_time = 0;
+    }
+  } else {
+    calm_time = 0;
+    if (interval > DHT11_POLL_INTERVAL) {
+      interval = DHT11_POLL_INTERVAL;
+    }
+  }
+  if (interval == poll_interval) return;
+
+  LOG_INFO("Polling every %u ms\n", interval);
+  poll_interval = interval;
+  task_profile_remove_task(&collector_profile, collector_task_id);
+  struct task_config collector_task_config = { "htcol", TASK_FOREVER, interval / HUM_TEMP_SENSORS };
+  collector_task_id = task_profile_add_task(&collector_profile, &collector_task_config, collector_task, NULL);
 }
 
-void hum_temp_read(event_handler on_reading) {
+// Compares the raw reading, before the spike filter, with the last one
+// and the EWMA
+static bool reading_stepped(struct hum_temp_sensor* sensor, struct hum_temp_reading reading) {
+  if (sensor->recent_count > 0) {
+    struct hum_temp_reading last = sensor->recent_readings[ARRAY_SIZE(sensor->recent_readings) - 1];
+    if (abs(reading.humidity - last.humidity) >= POLL_STEP || abs(reading.temperature - last.temperature) >= POLL_STEP) {
+      return true;
+    }
+  }
+  int16_t from_ewma = ((int16_t) reading.humidity << HUM_TEMP_FRACTION_BITS) - (int16_t) sensor->humidity_ewma;
+  return monitoring && abs(from_ewma) >= (POLL_STEP << HUM_TEMP_FRACTION_BITS);
+}
+
+// The largest variance of any sensor's 20 second buffers
+static uint16_t buffer_variance(void) {
+  uint16_t largest = 0;
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    uint16_t humidity = sample_buffer_variance(&hum_temp_sensors[i].humidity_20_sec_buffer.super);
+    uint16_t temperature = sample_buffer_variance(&hum_temp_sensors[i].temperature_20_sec_buffer.super);
+    if (humidity > largest) largest = humidity;
+    if (temperature > largest) largest = temperature;
+  }
+  return largest;
+}
+
+static uint8_t take_next_sensor(void) {
+  uint8_t sensor = next_sensor;
+  if (++next_sensor == HUM_TEMP_SENSORS) {
+    next_sensor = 0;
+  }
+  return sensor;
+}
+
+void hum_temp_read(uint8_t sensor, event_handler on_reading) {
   event_add_listener(EVENT_TYPE_HUM_TEMP, EVENT_DESCRIPTOR_HUM_TEMP_READING, on_reading);
-  dht11_signal_start(&sensor_gpio);
-  struct task_config read_task_config = { "dhtrd", TASK_ONCE, 18 };
-	scheduler_add_task(&read_task_config, hum_temp_complete_read, &sensor_gpio);
+  read_attempt = 0;
+  struct task start = { .data = &hum_temp_sensors[sensor] };
+  start_read_attempt(&start);
+}
+
+// The read tasks carry the sensor in their data
+static void start_read_attempt(struct task* task) {
+  struct hum_temp_sensor* sensor = (struct hum_temp_sensor*) task->data;
+  dht11_signal_start(&sensor->gpio);
+  struct task_config read_task_config = { "dhtrd", TASK_ONCE, DHT11_START_TIME };
+	task_profile_add_task(&read_profile, &read_task_config, hum_temp_begin_read, sensor);
+}
+
+static void hum_temp_begin_read(struct task* task) {
+  dht11_begin_read(&((struct hum_temp_sensor*) task->data)->gpio);
+  struct task_config complete_task_config = { "dhtfn", TASK_ONCE, DHT11_FRAME_TIME };
+	task_profile_add_task(&complete_read_profile, &complete_task_config, hum_temp_complete_read, task->data);
 }
 
 static void hum_temp_complete_read(struct task* task) {
+  struct hum_temp_sensor* sensor = (struct hum_temp_sensor*) task->data;
   uint8_t dht11_data[5];
-  result_t result = dht11_read((struct gpio*) task->data, dht11_data);
+  result_t result = dht11_end_read(&sensor->gpio, dht11_data);
   
+  if (result != RESULT_SUCCESS && read_attempt < READ_RETRIES) {
+    struct task_config retry_task_config = { "dhtrt", TASK_ONCE, READ_RETRY_BACKOFF << read_attempt };
+    task_profile_add_task(&retry_read_profile, &retry_task_config, start_read_attempt, sensor);
+    read_attempt++;
+    return;
+  }
+
+  current_read_event.sensor = sensor - hum_temp_sensors;
+
   if (result == RESULT_SUCCESS) {
     struct hum_temp_reading reading = { dht11_data[0], dht11_data[2] };
     current_read_event.reading = reading;
+    current_read_event.valid = true;
   } else {
     current_read_event.reading = (struct hum_temp_reading) { 0 };    
+    current_read_event.valid = false;
   }
   event_fire_event((event_t*) &current_read_event);
 }
 
 static bool on_hum_temp_reading(event_t* event) {
   struct hum_temp_read_event* read_event = (struct hum_temp_read_event*) event;
+  struct hum_temp_sensor* sensor = &hum_temp_sensors[read_event->sensor];
   struct hum_temp_reading current_reading = read_event->reading;
-  if (current_reading.temperature == 0 && current_reading.humidity == 0) {
-    LOG_ERROR("No humidity / temperature reading received\n", "");
+  uint8_t seconds = poll_interval / 1000;
+  // Every sensor is read once per poll interval
+  if (read_event->sensor == 0) {
+    device_seconds += seconds;
   }
 
-  push_sample(&humidity_20_sec_buffer, current_reading.humidity);
-  push_sample(&humidity_10_min_buffer, current_reading.humidity);
+  if (!read_event->valid) {
+    LOG_ERROR("No humidity / temperature reading received from sensor %u\n", read_event->sensor);
+    sample_buffer_10_push_invalid(&sensor->humidity_20_sec_buffer);
+    sample_buffer_10_push_invalid(&sensor->temperature_20_sec_buffer);
+  } else {
+    if (sensor->verify_warm_start) {
+      sensor->verify_warm_start = false;
+      if (!warm_start_agrees(sensor, current_reading)) {
+        LOG_INFO("Snapshot is stale\n", "");
+        for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+          hum_temp_sensors[i].verify_warm_start = false;
+        }
+        event_fire_event(&current_stale_event);
+        return false;
+      }
+    }
+    if (reading_stepped(sensor, current_reading)) {
+      step_seen = true;
+    }
+    current_reading = filter_spikes(sensor, current_reading);
+    sensor->slot_humidity += current_reading.humidity * seconds;
+    sensor->slot_temperature += current_reading.temperature * seconds;
+    sensor->slot_weight += seconds;
+  }
+  sensor->slot_time += poll_interval;
+  if (sensor->slot_time >= DHT11_POLL_INTERVAL) {
+    push_slots(sensor);
+  }
+  if (step_seen && next_sensor == 0 && poll_interval > POLL_MIN_INTERVAL && collector_profile.active) {
+    adapt_poll_interval();
+  }
 
-  push_sample(&temperature_20_sec_buffer, current_reading.temperature);
-  push_sample(&temperature_10_min_buffer, current_reading.temperature);
+  if (monitoring && read_event->valid) {
+    detect_change(sensor, current_reading.humidity, seconds);
+  }
 
   return false;
 }
 
-uint16_t hum_temp_load(void) {
-  uint16_t pos = 0;
-  for (uint8_t i = 0; i < ARRAY_SIZE(sample_buffers); i++) {
-    sample_buffer_init(sample_buffers[i], sample_buffers[i]->samples, sample_buffers[i]->size);
-    eeprom_read_buffer(sample_buffers[i], pos);
-    pos += sample_buffers[i]->count + 2;
+// Each DHT11_POLL_INTERVAL the readings have covered goes into the
+// buffers as one sample: their time weighted mean, so a slow reading
+// fills several samples and two fast ones share one. A failed read
+// takes its samples too but is left out of the sums and means, unless
+// a good reading shares them.
+static void push_slots(struct hum_temp_sensor* sensor) {
+  uint8_t weight = sensor->slot_weight;
+  uint8_t humidity = 0;
+  uint8_t temperature = 0;
+  if (weight > 0) {
+    humidity = (sensor->slot_humidity + (weight >> 1)) / weight;
+    temperature = (sensor->slot_temperature + (weight >> 1)) / weight;
+  }
+
+  for (; sensor->slot_time >= DHT11_POLL_INTERVAL; sensor->slot_time -= DHT11_POLL_INTERVAL) {
+    if (weight > 0) {
+      sample_buffer_10_push(&sensor->humidity_20_sec_buffer, humidity);
+      sample_buffer_10_push(&sensor->temperature_20_sec_buffer, temperature);
+      delta_buffer_push(&sensor->humidity_history.super, humidity);
+      delta_buffer_push(&sensor->temperature_history.super, temperature);
+    } else {
+      sample_buffer_10_push_invalid(&sensor->humidity_20_sec_buffer);
+      sample_buffer_10_push_invalid(&sensor->temperature_20_sec_buffer);
+      delta_buffer_push(&sensor->humidity_history.super, DELTA_BUFFER_INVALID);
+      delta_buffer_push(&sensor->temperature_history.super, DELTA_BUFFER_INVALID);
+    }
+
+    bool window_complete = bucket_buffer_30_roll(&sensor->humidity_10_min_buffer, &sensor->humidity_20_sec_buffer.super);
+    bucket_buffer_30_roll(&sensor->temperature_10_min_buffer, &sensor->temperature_20_sec_buffer.super);
+    if (window_complete) {
+      roll_up_window(sensor);
+      if (sensor->unsaved_windows < ARRAY_SIZE(sensor->humidity_10_min_buffer.buckets)) {
+        sensor->unsaved_windows++;
+      }
+    }
+  }
+  clear_slot(sensor);
+
+  if (sensor->unsaved_windows >= AUTOSAVE_WINDOWS) {
+    hum_temp_save(NULL);
+  }
+}
+
+// Also drops what is left of a part sample, as after a stop
+static void clear_slot(struct hum_temp_sensor* sensor) {
+  sensor->slot_humidity = 0;
+  sensor->slot_temperature = 0;
+  sensor->slot_weight = 0;
+  sensor->slot_time = 0;
+}
+
+// Folds the window just rolled up into the hour, its mean being both its
+// min and max, after writing out the hour and the day if it has moved on
+// from them. Partial hours and days, such as those a restart cuts
+// short, are written out all the same.
+static void roll_up_window(struct hum_temp_sensor* sensor) {
+  uint8_t s = sensor - hum_temp_sensors;
+  uint16_t hour = device_seconds / ROLLUP_HOUR_SECONDS;
+  struct rollup* hour_rollup = &sensor->hour_rollup;
+  struct rollup* day_rollup = &sensor->day_rollup;
+  if (hour_rollup->samples > 0 && hour_rollup->period != hour) {
+    write_rollup(ROLLUP_LOG_HOURS, s, hour_rollup);
+    if (day_rollup->samples == 0) {
+      day_rollup->period = hour_rollup->period / ROLLUP_HOURS_PER_DAY;
+    }
+    merge_rollup(day_rollup, hour_rollup);
+    *hour_rollup = (struct rollup) { 0 };
+    if (day_rollup->period != hour / ROLLUP_HOURS_PER_DAY) {
+      write_rollup(ROLLUP_LOG_DAYS, s, day_rollup);
+      *day_rollup = (struct rollup) { 0 };
+    }
+  }
+  hour_rollup->period = hour;
+
+  uint8_t last = sensor->humidity_10_min_buffer.super.count - 1;
+  uint8_t window = sensor->humidity_10_min_buffer.super.window;
+  struct rollup window_rollup = {
+    .samples = window,
+    .sums = {
+      bucket_at(&sensor->humidity_10_min_buffer.super, last),
+      bucket_at(&sensor->temperature_10_min_buffer.super, last)
+    }
+  };
+  for (uint8_t c = 0; c < SAMPLE_LOG_CHANNELS; c++) {
+    window_rollup.min[c] = (window_rollup.sums[c] + (window >> 1)) / window;
+    window_rollup.max[c] = window_rollup.min[c];
+  }
+  merge_rollup(hour_rollup, &window_rollup);
+}
+
+static void merge_rollup(struct rollup* into, const struct rollup* from) {
+  for (uint8_t c = 0; c < SAMPLE_LOG_CHANNELS; c++) {
+    if (into->samples == 0 || from->min[c] < into->min[c]) {
+      into->min[c] = from->min[c];
+    }
+    if (into->samples == 0 || from->max[c] > into->max[c]) {
+      into->max[c] = from->max[c];
+    }
+    into->sums[c] += from->sums[c];
+  }
+  into->samples += from->samples;
+}
+
+static void write_rollup(uint8_t kind, uint8_t sensor, const struct rollup* rollup) {
+  if (rollup_queue_count == ROLLUP_QUEUE_SIZE) return;
+
+  uint8_t tail = rollup_queue_head + rollup_queue_count;
+  if (tail >= ROLLUP_QUEUE_SIZE) tail -= ROLLUP_QUEUE_SIZE;
+  struct queued_rollup* queued = &rollup_queue[tail];
+  queued->kind = kind;
+  queued->record = (struct rollup_record) { .sensor = sensor, .period = rollup->period };
+  for (uint8_t c = 0; c < SAMPLE_LOG_CHANNELS; c++) {
+    queued->record.min[c] = rollup->min[c];
+    queued->record.max[c] = rollup->max[c];
+    queued->record.mean[c] = (rollup->sums[c] + (rollup->samples >> 1)) / rollup->samples;
+  }
+  rollup_queue_count++;
+
+  if (rollup_task_id == TASK_NO_TASK) {
+    struct task_config rollup_task_config = { "htru", TASK_FOREVER, ROLLUP_WRITE_INTERVAL };
+    rollup_task_id = task_profile_add_task(&rollup_profile, &rollup_task_config, rollup_task, NULL);
+  }
+}
+
+// Retries until the writer is free, like save_task, and goes once the
+// queue is empty
+static void rollup_task(struct task* task) {
+  if (!rollup_log_ready()) return;
+
+  struct queued_rollup* queued = &rollup_queue[rollup_queue_head];
+  rollup_log_append(queued->kind, &queued->record);
+  if (++rollup_queue_head == ROLLUP_QUEUE_SIZE) rollup_queue_head = 0;
+  if (--rollup_queue_count == 0) {
+    task_profile_remove_task(&rollup_profile, rollup_task_id);
+    rollup_task_id = TASK_NO_TASK;
   }
-  return pos;
 }
 
-uint16_t hum_temp_save(void) {
-  uint16_t pos = 0;
-  for (uint8_t i = 0; i < ARRAY_SIZE(sample_buffers); i++) {
-    eeprom_write_buffer(sample_buffers[i], pos);
-    pos += sample_buffers[i]->count + 2;
+// Median of the reading and the two good readings before it, so a
+// single-sample spike never reaches the buffers
+static struct hum_temp_reading filter_spikes(struct hum_temp_sensor* sensor, struct hum_temp_reading reading) {
+  struct hum_temp_reading* recent = sensor->recent_readings;
+  struct hum_temp_reading filtered = reading;
+  if (sensor->recent_count == ARRAY_SIZE(sensor->recent_readings)) {
+    filtered.humidity = median_of_3(recent[0].humidity, recent[1].humidity, reading.humidity);
+    filtered.temperature = median_of_3(recent[0].temperature, recent[1].temperature, reading.temperature);
+  } else {
+    sensor->recent_count++;
   }
-  return pos;
+  recent[0] = recent[1];
+  recent[1] = reading;
+  return filtered;
 }
 
-struct hum_temp_stats hum_temp_current_stats(void) {
-  struct hum_temp_stats stats = { 0 };
-  if (humidity_20_sec_buffer.count > 0) {
-    stats.humidity_av_20_sec = humidity_20_sec_buffer.sum / humidity_20_sec_buffer.count;    
+static uint8_t median_of_3(uint8_t a, uint8_t b, uint8_t c) {
+  if (a > b) {
+    uint8_t t = a; a = b; b = t;
   }
-  if (humidity_10_min_buffer.count > 0) {
-    stats.humidity_av_10_min = humidity_10_min_buffer.sum / humidity_10_min_buffer.count;
+  if (c <= a) return a;
+  if (c >= b) return b;
+  return c;
+}
+
+static bool warm_start_agrees(struct hum_temp_sensor* sensor, struct hum_temp_reading reading) {
+  int16_t humidity_error = reading.humidity - HUM_TEMP_ROUND(sensor->humidity_20_sec_buffer.super.mean);
+  int16_t temperature_error = reading.temperature - HUM_TEMP_ROUND(sensor->temperature_20_sec_buffer.super.mean);
+  return abs(humidity_error) <= WARM_START_HUMIDITY_TOLERANCE
+    && abs(temperature_error) <= WARM_START_TEMPERATURE_TOLERANCE;
+}
+
+// Rebuilds the 10 minute buckets by replaying the newest windows in the
+// log, whose entries each belong to one sensor; the 20 second buffers
+// restart at the mean of the sensor's last window. The log has no raw
+// samples, so the histories start empty.
+uint16_t hum_temp_load(void) {
+  for (uint8_t s = 0; s < HUM_TEMP_SENSORS; s++) {
+    reset_buffers(&hum_temp_sensors[s]);
   }
-  if (temperature_20_sec_buffer.count > 0) {
-    stats.temperature_av_20_sec = temperature_20_sec_buffer.sum / temperature_20_sec_buffer.count;    
+
+  uint8_t entries = sample_log_replay(HUM_TEMP_SENSORS * ARRAY_SIZE(hum_temp_sensors[0].humidity_10_min_buffer.buckets), on_log_entry);
+  for (uint8_t s = 0; s < HUM_TEMP_SENSORS; s++) {
+    struct hum_temp_sensor* sensor = &hum_temp_sensors[s];
+    if (sensor->humidity_10_min_buffer.super.count > 0) {
+      uint8_t last = sensor->humidity_10_min_buffer.super.count - 1;
+      uint8_t window = sensor->humidity_10_min_buffer.super.window;
+      uint8_t humidity = (bucket_at(&sensor->humidity_10_min_buffer.super, last) + (window >> 1)) / window;
+      uint8_t temperature = (bucket_at(&sensor->temperature_10_min_buffer.super, last) + (window >> 1)) / window;
+      for (uint8_t i = 0; i < window; i++) {
+        sample_buffer_10_push(&sensor->humidity_20_sec_buffer, humidity);
+        sample_buffer_10_push(&sensor->temperature_20_sec_buffer, temperature);
+      }
+    }
+    sensor->unsaved_windows = 0;
   }
-  if (temperature_10_min_buffer.count > 0) {
-    stats.temperature_av_10_min = temperature_10_min_buffer.sum / temperature_10_min_buffer.count;
+
+  return entries * sizeof(struct sample_log_entry);
+}
+
+static void reset_buffers(struct hum_temp_sensor* sensor) {
+  sample_buffer_clear(&sensor->humidity_20_sec_buffer.super);
+  bucket_buffer_clear(&sensor->humidity_10_min_buffer.super);
+  delta_buffer_clear(&sensor->humidity_history.super);
+  sample_buffer_clear(&sensor->temperature_20_sec_buffer.super);
+  bucket_buffer_clear(&sensor->temperature_10_min_buffer.super);
+  delta_buffer_clear(&sensor->temperature_history.super);
+}
+
+static void on_log_entry(const struct sample_log_entry* entry) {
+  if (entry->sensor >= HUM_TEMP_SENSORS) return;
+  struct hum_temp_sensor* sensor = &hum_temp_sensors[entry->sensor];
+  if (entry->samples != sensor->humidity_10_min_buffer.super.window) return;
+  bucket_buffer_30_push(&sensor->humidity_10_min_buffer, entry->sums[0]);
+  bucket_buffer_30_push(&sensor->temperature_10_min_buffer, entry->sums[1]);
+}
+
+// Appends the windows completed since the last save to the log, one
+// entry per tick of the "htsv" task, while collection carries on, then
+// writes a snapshot header. Returns the number of windows still to
+// write. on_complete may be NULL.
+uint8_t hum_temp_save(event_handler on_complete) {
+  if (on_complete != NULL) {
+    event_add_listener(EVENT_TYPE_HUM_TEMP, EVENT_DESCRIPTOR_HUM_TEMP_SAVE, on_complete);
+  }
+  if (save_task_id == TASK_NO_TASK) {
+    current_save_event.bytes_written = 0;
+    save_snapshot_written = false;
+    struct task_config save_task_config = { "htsv", TASK_FOREVER, SAVE_INTERVAL };
+    save_task_id = task_profile_add_task(&save_profile, &save_task_config, save_task, NULL);
+  }
+  return hum_temp_save_pending();
+}
+
+uint8_t hum_temp_save_pending(void) {
+  uint8_t pending = 0;
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    struct hum_temp_sensor* sensor = &hum_temp_sensors[i];
+    if (sensor->unsaved_windows > sensor->humidity_10_min_buffer.super.count) {
+      sensor->unsaved_windows = sensor->humidity_10_min_buffer.super.count;
+    }
+    pending += sensor->unsaved_windows;
+  }
+  return pending;
+}
+
+// unsaved_windows counts back from the newest bucket, so windows rolled
+// up while the save runs are picked up rather than shifting it. Each
+// sensor's windows go to the log as entries of their own, so a sensor
+// that drops windows doesn't put the others out of step.
+static void save_task(struct task* task) {
+  if (!sample_log_ready()) return;
+
+  if (hum_temp_save_pending() == 0) {
+    if (!save_snapshot_written) {
+      struct snapshot snapshot = {
+        .windows = sample_log_run_length(),
+        .saved_at = device_seconds
+      };
+      if (sample_log_head_seq(&snapshot.head_seq)) {
+        current_save_event.bytes_written += snapshot_write(&snapshot);
+      }
+      save_snapshot_written = true;
+      return;
+    }
+    task_profile_remove_task(&save_profile, save_task_id);
+    save_task_id = TASK_NO_TASK;
+    event_fire_event((event_t*) &current_save_event);
+    return;
   }
+
+  uint8_t s = 0;
+  while (hum_temp_sensors[s].unsaved_windows == 0) {
+    s++;
+  }
+  struct hum_temp_sensor* sensor = &hum_temp_sensors[s];
+  uint8_t i = sensor->humidity_10_min_buffer.super.count - sensor->unsaved_windows;
+  struct sample_log_entry entry = {
+    .sums = {
+      bucket_at(&sensor->humidity_10_min_buffer.super, i),
+      bucket_at(&sensor->temperature_10_min_buffer.super, i)
+    },
+    .sensor = s,
+    .samples = sensor->humidity_10_min_buffer.super.window
+  };
+  current_save_event.bytes_written += sample_log_append(&entry);
+  sensor->unsaved_windows--;
+}
+
+struct hum_temp_stats hum_temp_current_stats(uint8_t sensor) {
+  struct hum_temp_sensor* current = &hum_temp_sensors[sensor];
+  struct hum_temp_stats stats = {
+    .humidity_av_20_sec = current->humidity_20_sec_buffer.super.mean,
+    .humidity_av_10_min = current->humidity_10_min_buffer.super.mean,
+    .temperature_av_20_sec = current->temperature_20_sec_buffer.super.mean,
+    .temperature_av_10_min = current->temperature_10_min_buffer.super.mean
+  };
   return stats;
 }
 
 void hum_temp_print_stats(FILE* stream) {
-  struct hum_temp_stats stats = hum_temp_current_stats();
-  
-  WT_PGM_STR(WETECTOR_SHELL_STATS_HEADER, shell_stats_header);
-  WT_PGM_STR(WETECTOR_SHELL_STATS_ROW, shell_stats_row);
-  
-  fprintf(stream, shell_stats_header);
-  fprintf(stream, shell_stats_row, "H", stats.humidity_av_20_sec, stats.humidity_av_10_min);
-  fprintf(stream, shell_stats_row, "T", stats.temperature_av_20_sec, stats.temperature_av_10_min);
+  fputs_P(WT_PGM_WETECTOR_SHELL_STATS_HEADER, stream);
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    struct hum_temp_stats stats = hum_temp_current_stats(i);
+    print_format_P(stream, WT_PGM_WETECTOR_SHELL_STATS_ROW, channel_label('H', i),
+      WHOLE(stats.humidity_av_20_sec), TENTHS(stats.humidity_av_20_sec),
+      WHOLE(stats.humidity_av_10_min), TENTHS(stats.humidity_av_10_min));
+    print_format_P(stream, WT_PGM_WETECTOR_SHELL_STATS_ROW, channel_label('T', i),
+      WHOLE(stats.temperature_av_20_sec), TENTHS(stats.temperature_av_20_sec),
+      WHOLE(stats.temperature_av_10_min), TENTHS(stats.temperature_av_10_min));
+  }
 
   fputc('\n', stream);
 }
 
-void hum_temp_print_samples(FILE* stream) {
-  WT_PGM_STR(WETECTOR_SHELL_SAMPLES_20_SEC, shell_samples_20_sec);
-  WT_PGM_STR(WETECTOR_SHELL_SAMPLES_10_MIN, shell_samples_10_min);
-  
-  fprintf(stream, shell_samples_20_sec, "H");
-  print_sample_buffer(&humidity_20_sec_buffer, stream);
-  fprintf(stream, shell_samples_10_min, "H");
-  print_sample_buffer(&humidity_10_min_buffer, stream);
-  fprintf(stream, shell_samples_20_sec, "T");
-  print_sample_buffer(&temperature_20_sec_buffer, stream);
-  fprintf(stream, shell_samples_10_min, "T");
-  print_sample_buffer(&temperature_10_min_buffer, stream);
+// Two rows a record, humidity then temperature, each led by the
+// record's place counting back from the newest and its hour or day
+bool hum_temp_print_rollups(uint8_t kind, uint8_t page, FILE* stream) {
+  struct rollup_record record;
+  uint16_t first = (uint16_t) page * ROLLUP_PAGE_RECORDS;
+  if (first > UINT8_MAX || !rollup_log_read(kind, first, &record)) return false;
+
+  print_format_P(stream, WT_PGM_WETECTOR_SHELL_ROLLUP_HEADER, kind == ROLLUP_LOG_DAYS ? 'd' : 'h');
+  for (uint8_t i = first; i < first + ROLLUP_PAGE_RECORDS && rollup_log_read(kind, i, &record); i++) {
+    print_format_P(stream, WT_PGM_WETECTOR_SHELL_ROLLUP_ROW, i, record.period, channel_label('H', record.sensor),
+      record.min[0], record.max[0], record.mean[0]);
+    print_format_P(stream, WT_PGM_WETECTOR_SHELL_ROLLUP_ROW, i, record.period, channel_label('T', record.sensor),
+      record.min[1], record.max[1], record.mean[1]);
+  }
+  fputc('\n', stream);
+  return true;
+}
+
+// "H" or "T" with one sensor, "H0", "T1" and so on with more
+static const char* channel_label(char channel, uint8_t sensor) {
+  static char label[3];
+  label[0] = channel;
+  label[1] = HUM_TEMP_SENSORS > 1 ? '0' + sensor : '\0';
+  return label;
+}
+
+void hum_temp_send_stats(FILE* stream) {
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    struct hum_temp_stats stats = hum_temp_current_stats(i);
+
+    telemetry_begin(TELEMETRY_TYPE_STATS);
+    telemetry_put(i);
+    telemetry_put_word(stats.humidity_av_20_sec);
+    telemetry_put_word(stats.humidity_av_10_min);
+    telemetry_put_word(stats.temperature_av_20_sec);
+    telemetry_put_word(stats.temperature_av_10_min);
+    telemetry_end(stream);
+  }
+}
+
+void hum_temp_print_diagnostics(FILE* stream) {
+  const struct dht11_diagnostics* diagnostics = dht11_diagnostics();
+
+  print_format_P(stream, WT_PGM_WETECTOR_SHELL_DHT11_LAST, diagnostics->result, diagnostics->bits);
+  print_format_P(stream, WT_PGM_WETECTOR_SHELL_DHT11_PULSES, dht11_ticks_to_us(diagnostics->pulse_min),
+    dht11_ticks_to_us(diagnostics->pulse_max), dht11_ticks_to_us(diagnostics->threshold));
+  print_format_P(stream, WT_PGM_WETECTOR_SHELL_DHT11_RESULTS,
+    diagnostics->results[DHT11_RESULT_SUCCESS], diagnostics->results[DHT11_RESULT_FAIL_START_1],
+    diagnostics->results[DHT11_RESULT_FAIL_START_2], diagnostics->results[DHT11_RESULT_FAIL_CHECKSUM],
+    diagnostics->results[DHT11_RESULT_FAIL_TIMEOUT]);
+
+  fputc('\n', stream);
+}
+
+void hum_temp_send_diagnostics(FILE* stream) {
+  const struct dht11_diagnostics* diagnostics = dht11_diagnostics();
+
+  telemetry_begin(TELEMETRY_TYPE_DIAGNOSTICS);
+  telemetry_put(diagnostics->result);
+  telemetry_put(diagnostics->bits);
+  telemetry_put_word(dht11_ticks_to_us(diagnostics->pulse_min));
+  telemetry_put_word(dht11_ticks_to_us(diagnostics->pulse_max));
+  telemetry_put_word(dht11_ticks_to_us(diagnostics->threshold));
+  for (uint8_t i = 0; i < DHT11_RESULT_COUNT; i++) {
+    telemetry_put_word(diagnostics->results[i]);
+  }
+  telemetry_end(stream);
+}
+
+void hum_temp_reset_diagnostics(void) {
+  dht11_reset_diagnostics();
+}
+
+bool hum_temp_print_samples(uint8_t sensor, FILE* stream) {
+  if (dump_task_id != TASK_NO_TASK || sensor >= HUM_TEMP_SENSORS) return false;
+  dump_sensor = &hum_temp_sensors[sensor];
+  sample_buffer_10_copy(&dump_buffers[0], &dump_sensor->humidity_20_sec_buffer);
+  sample_buffer_10_copy(&dump_buffers[1], &dump_sensor->temperature_20_sec_buffer);
+  for (uint8_t i = 0; i < ARRAY_SIZE(dump_buffers); i++) {
+    sample_cursor_open(&dump_buffer_cursors[i], &dump_buffers[i].super);
+  }
+  bucket_cursor_open(&dump_bucket_cursors[0], &dump_sensor->humidity_10_min_buffer.super);
+  bucket_cursor_open(&dump_bucket_cursors[1], &dump_sensor->temperature_10_min_buffer.super);
+  delta_cursor_open(&dump_history_cursors[0], &dump_sensor->humidity_history.super);
+  delta_cursor_open(&dump_history_cursors[1], &dump_sensor->temperature_history.super);
+  dump_part = 0;
+  dump_stream = stream;
+  print_dump_header(dump_part);
+  // The first run goes out with the command, the rest from the task
+  dump_next();
+  struct task_config dump_task_config = { "htdmp", TASK_FOREVER, DUMP_INTERVAL };
+  dump_task_id = task_profile_add_task(&dump_profile, &dump_task_config, dump_task, NULL);
+  return true;
+}
+
+static void dump_task(struct task* task) {
+  if (dump_next()) return;
+  task_profile_remove_task(&dump_profile, dump_task_id);
+  dump_task_id = TASK_NO_TASK;
+}
+
+// Each channel's 20 second buffer, 10 minute buckets and raw history,
+// humidity first. False once the last part is out.
+static bool dump_next(void) {
+  bool more;
+  switch (dump_part) {
+  case 0:
+    more = print_sample_buffer_chunk(&dump_buffers[0].super, &dump_buffer_cursors[0], DUMP_SAMPLES_PER_RUN, dump_stream);
+    break;
+  case 1:
+    more = print_bucket_buffer_chunk(&dump_sensor->humidity_10_min_buffer.super, &dump_bucket_cursors[0], DUMP_SAMPLES_PER_RUN, dump_stream);
+    break;
+  case 2:
+    more = print_delta_buffer_chunk(&dump_sensor->humidity_history.super, &dump_history_cursors[0], DUMP_SAMPLES_PER_RUN, dump_stream);
+    break;
+  case 3:
+    more = print_sample_buffer_chunk(&dump_buffers[1].super, &dump_buffer_cursors[1], DUMP_SAMPLES_PER_RUN, dump_stream);
+    break;
+  case 4:
+    more = print_bucket_buffer_chunk(&dump_sensor->temperature_10_min_buffer.super, &dump_bucket_cursors[1], DUMP_SAMPLES_PER_RUN, dump_stream);
+    break;
+  default:
+    more = print_delta_buffer_chunk(&dump_sensor->temperature_history.super, &dump_history_cursors[1], DUMP_SAMPLES_PER_RUN, dump_stream);
+    break;
+  }
+  if (more) return true;
+
+  if (++dump_part < DUMP_PARTS) {
+    print_dump_header(dump_part);
+    return true;
+  }
+  return false;
+}
+
+static void print_dump_header(uint8_t part) {
+  const char* channel = channel_label(part < 3 ? 'H' : 'T', dump_sensor - hum_temp_sensors);
+  switch (part % 3) {
+  case 0:
+    print_format_P(dump_stream, WT_PGM_WETECTOR_SHELL_SAMPLES_20_SEC, channel);
+    break;
+  case 1:
+    print_format_P(dump_stream, WT_PGM_WETECTOR_SHELL_SAMPLES_10_MIN, channel);
+    break;
+  default:
+    print_format_P(dump_stream, WT_PGM_WETECTOR_SHELL_SAMPLES_RAW, channel);
+    break;
+  }
+}
+
+void hum_temp_send_samples(FILE* stream) {
+  for (uint8_t i = 0; i < HUM_TEMP_SENSORS; i++) {
+    struct hum_temp_sensor* sensor = &hum_temp_sensors[i];
+    telemetry_send_sample_buffer(TELEMETRY_BUFFER_ID(i, TELEMETRY_HUMIDITY_20_SEC), &sensor->humidity_20_sec_buffer.super, stream);
+    telemetry_send_bucket_buffer(TELEMETRY_BUFFER_ID(i, TELEMETRY_HUMIDITY_10_MIN), &sensor->humidity_10_min_buffer.super, stream);
+    telemetry_send_sample_buffer(TELEMETRY_BUFFER_ID(i, TELEMETRY_TEMPERATURE_20_SEC), &sensor->temperature_20_sec_buffer.super, stream);
+    telemetry_send_bucket_buffer(TELEMETRY_BUFFER_ID(i, TELEMETRY_TEMPERATURE_10_MIN), &sensor->temperature_10_min_buffer.super, stream);
+  }
 }
 
 
@@ -9,35 +9,57 @@
 #include "event/event.h"
 #include "scheduler.h"
 
+#define EVENT_TYPE_HUM_TEMP 0x06
+#define EVENT_DESCRIPTOR_HUM_TEMP_READING 0x00
+#define EVENT_DESCRIPTOR_HUM_TEMP_CHANGE 0x01
+#define EVENT_DESCRIPTOR_HUM_TEMP_CALIBRATE 0x02
+#define EVENT_DESCRIPTOR_HUM_TEMP_SAVE 0x03
+#define EVENT_DESCRIPTOR_HUM_TEMP_STALE 0x04
+
 
 struct hum_temp_reading {
   uint8_t humidity;
   uint8_t temperature;
 };
 
+// Averages are fixed point with HUM_TEMP_FRACTION_BITS fractional bits
+#define HUM_TEMP_FRACTION_BITS 8
+#define HUM_TEMP_ROUND(VALUE) (((VALUE) + (1 << (HUM_TEMP_FRACTION_BITS - 1))) >> HUM_TEMP_FRACTION_BITS)
+
 struct hum_temp_stats {
-  uint8_t humidity_av_20_sec;
-  uint8_t humidity_av_10_min;
-  uint8_t temperature_av_20_sec;
-  uint8_t temperature_av_10_min;
+  uint16_t humidity_av_20_sec;
+  uint16_t humidity_av_10_min;
+  uint16_t temperature_av_20_sec;
+  uint16_t temperature_av_10_min;
 };
 
 struct hum_temp_read_event {
 	event_t super;
+  uint8_t sensor;
   struct hum_temp_reading reading; 
+  bool valid;
 };
 
 struct hum_temp_change_event {
 	event_t super;
+  uint8_t sensor;
   struct hum_temp_stats stats; 
 };
 
+struct hum_temp_save_event {
+	event_t super;
+  uint16_t bytes_written;
+};
+
 void hum_temp_init(void);
 
-void hum_temp_read(event_handler on_reading);
+// Sensors are numbered in the order of HUM_TEMP_SENSOR_PINS
+void hum_temp_read(uint8_t sensor, event_handler on_reading);
 
 void hum_temp_calibrate(event_handler on_complete);
 
+bool hum_temp_warm_start(event_handler on_stale);
+
 void hum_temp_start_collector(void);
 
 void hum_temp_stop_collector(void);
@@ -46,14 +68,43 @@ void hum_temp_start_monitor(event_handler on_change);
 
 void hum_temp_stop_monitor(void);
 
+#define HUM_TEMP_MAX_CHANGE_THRESHOLD 100
+
+// Both in whole %RH; false, leaving them as they were, if the
+// threshold is over HUM_TEMP_MAX_CHANGE_THRESHOLD
+bool hum_temp_set_change_threshold(uint8_t threshold, uint8_t hysteresis);
+
 uint16_t hum_temp_load(void);
 
-uint16_t hum_temp_save(void);
+uint8_t hum_temp_save(event_handler on_complete);
 
-struct hum_temp_stats hum_temp_current_stats(void);
+uint8_t hum_temp_save_pending(void);
+
+struct hum_temp_stats hum_temp_current_stats(uint8_t sensor);
 
 void hum_temp_print_stats(FILE* stream);
 
-void hum_temp_print_samples(FILE* stream);
+void hum_temp_print_diagnostics(FILE* stream);
+
+void hum_temp_reset_diagnostics(void);
+
+// Starts printing the sensor's buffers, a few samples per scheduler
+// run; false if a dump is still going. The 20 second buffers and 10
+// minute buckets print as they are now, but the raw histories may lose
+// their oldest samples to readings taken while the dump runs.
+bool hum_temp_print_samples(uint8_t sensor, FILE* stream);
+
+// Prints a page of the hourly or daily records in the rollup log
+// (ROLLUP_LOG_HOURS or ROLLUP_LOG_DAYS), newest first from page 0;
+// false if the page is past the oldest
+bool hum_temp_print_rollups(uint8_t kind, uint8_t page, FILE* stream);
+
+// Telemetry packets (see telemetry.h) with the same content as the
+// print functions above
+void hum_temp_send_stats(FILE* stream);
+
+void hum_temp_send_diagnostics(FILE* stream);
+
+void hum_temp_send_samples(FILE* stream);
 
 #endif
@@ -0,0 +1,145 @@
+#include <inttypes.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#include "hal/hal.h"
+#include "led.h"
+
+// Timer1 runs 8-bit fast PWM at /64 for the blue channel (OC1A), like
+// Timer0 does for red and green. Its overflow, every 1.024 ms, clocks
+// the pattern engine in frames of LED_FRAME_OVERFLOWS.
+#define LED_FRAME_OVERFLOWS 16
+#define LED_MS_TO_FRAMES(MS) ((MS) * 1000UL / (LED_FRAME_OVERFLOWS * 1024UL))
+
+// A step shows a colour for a number of frames, or ramps to it from
+// the previous step with LED_STEP_FADE. LED_STEP_COLOUR stands for the
+// colour passed to led_play; a step of 0 frames holds forever.
+#define LED_STEP_COLOUR 0x0F
+#define LED_STEP_FADE 0x80
+
+struct led_step {
+  uint8_t colour;
+  uint8_t frames;
+};
+
+static const uint8_t colour_levels[LED_COLOUR_COUNT][3] PROGMEM = {
+  { 0, 0, 0 },
+  { 100, 0, 0 },
+  { 0, 100, 0 },
+  { 100, 22, 0 },
+  { 0, 0, 100 }
+};
+
+static const struct led_step steps[] PROGMEM = {
+  // LED_PATTERN_STEADY
+  { LED_STEP_COLOUR, 0 },
+  // LED_PATTERN_BLINK
+  { LED_STEP_COLOUR, LED_MS_TO_FRAMES(800) }, { OFF, LED_MS_TO_FRAMES(800) },
+  // LED_PATTERN_BREATHE
+  { LED_STEP_COLOUR | LED_STEP_FADE, LED_MS_TO_FRAMES(1000) },
+  { OFF | LED_STEP_FADE, LED_MS_TO_FRAMES(1000) },
+  // LED_PATTERN_CYCLE
+  { RED, LED_MS_TO_FRAMES(600) }, { YELLOW, LED_MS_TO_FRAMES(600) },
+  { GREEN, LED_MS_TO_FRAMES(600) }, { BLUE, LED_MS_TO_FRAMES(600) }
+};
+
+// Index of each pattern's first step, plus one past the last pattern
+static const uint8_t pattern_starts[LED_PATTERN_COUNT + 1] PROGMEM = { 0, 1, 3, 5, 9 };
+
+static struct gpio red_gpio = { .port = GPIO_PORT_D, .pin = GPIO_PIN_5 };
+static struct gpio green_gpio = { .port = GPIO_PORT_D, .pin = GPIO_PIN_6 };
+static struct gpio blue_gpio = { .port = GPIO_PORT_B, .pin = GPIO_PIN_1 };
+
+static struct gpio* gpios[] = { &red_gpio, &green_gpio, &blue_gpio };
+
+static uint8_t play_colour;
+static uint8_t pattern_start;
+static uint8_t pattern_end;
+static uint8_t step;
+static uint8_t frames;
+static uint8_t frame;
+static bool fade;
+static uint8_t overflows_left;
+static uint8_t from_levels[3];
+static uint8_t to_levels[3];
+static uint8_t levels[3];
+
+static void load_step(void);
+static void show(uint8_t i, uint8_t level);
+
+void led_init(void) {
+  for (uint8_t i = 0; i < 3; i++) {
+    gpio_set_mode(gpios[i], GPIO_OUTPUT);
+    gpio_set_duty_cycle(gpios[i], 0);
+  }
+  TCCR1A |= _BV(WGM10);
+  TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);
+  led_play(OFF, LED_PATTERN_STEADY);
+}
+
+void led_play(uint8_t colour, uint8_t pattern) {
+  if (colour >= LED_COLOUR_COUNT || pattern >= LED_PATTERN_COUNT) return;
+  TIMSK1 &= ~_BV(TOIE1);
+  play_colour = colour;
+  pattern_start = pgm_read_byte(&pattern_starts[pattern]);
+  pattern_end = pgm_read_byte(&pattern_starts[pattern + 1]);
+  step = pattern_start;
+  for (uint8_t i = 0; i < 3; i++) {
+    to_levels[i] = levels[i];
+  }
+  load_step();
+  // A single step that neither fades nor ends needs no interrupts
+  if (frames != 0) {
+    overflows_left = LED_FRAME_OVERFLOWS;
+    TIMSK1 |= _BV(TOIE1);
+  }
+}
+
+static void load_step(void) {
+  uint8_t colour = pgm_read_byte(&steps[step].colour);
+  frames = pgm_read_byte(&steps[step].frames);
+  frame = 0;
+  fade = colour & LED_STEP_FADE;
+  colour &= LED_STEP_COLOUR;
+  if (colour == LED_STEP_COLOUR) {
+    colour = play_colour;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    from_levels[i] = to_levels[i];
+    to_levels[i] = pgm_read_byte(&colour_levels[colour][i]);
+    if (!fade) {
+      show(i, to_levels[i]);
+    }
+  }
+}
+
+// Duty cycles only go out when they change
+static void show(uint8_t i, uint8_t level) {
+  if (level != levels[i]) {
+    gpio_set_duty_cycle(gpios[i], level);
+    levels[i] = level;
+  }
+}
+
+ISR(TIMER1_OVF_vect) {
+  if (--overflows_left) return;
+  overflows_left = LED_FRAME_OVERFLOWS;
+
+  frame++;
+  if (fade) {
+    for (uint8_t i = 0; i < 3; i++) {
+      int16_t span = (int16_t) to_levels[i] - from_levels[i];
+      show(i, from_levels[i] + span * frame / frames);
+    }
+  }
+  if (frame == frames) {
+    if (++step == pattern_end) {
+      step = pattern_start;
+    }
+    load_step();
+    if (frames == 0) {
+      TIMSK1 &= ~_BV(TOIE1);
+    }
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef LED_H
+#define LED_H
+
+#include <inttypes.h>
+
+#include "common.h"
+
+enum led_colour {
+  OFF, RED, GREEN, YELLOW, BLUE, LED_COLOUR_COUNT
+};
+
+enum led_pattern {
+  LED_PATTERN_STEADY, LED_PATTERN_BLINK, LED_PATTERN_BREATHE, LED_PATTERN_CYCLE,
+  LED_PATTERN_COUNT
+};
+
+// Plays a pattern on the status LED (PD5, PD6, PB1) until the next
+// call. Patterns are step tables in flash, walked by the Timer1
+// overflow interrupt; colour fills in the steps that don't name one.
+void led_init(void);
+
+void led_play(uint8_t colour, uint8_t pattern);
+
+#endif
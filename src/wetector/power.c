@@ -0,0 +1,113 @@
+#include <inttypes.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+#include "clock.h"
+#include "power.h"
+#include "print.h"
+#include "scheduler.h"
+#include "task_profile.h"
+#include "wetector/pgm_strings.h"
+
+// Idle is the deepest sleep that keeps Timer0 running, and with it the
+// millis tick, the red and green PWM and the DHT11 edge timestamps.
+// The tick wakes the CPU every ms or so, as do the LED, alarm, EEPROM,
+// UART and pin-change interrupts.
+#define POWER_SLEEP_MODE SLEEP_MODE_IDLE
+
+// Sleeps are timed with the Timer0 counter, taking one millis tick per
+// overflow like task_profile does. The time asleep adds up in ms with
+// the part-ms left over kept in ticks, so it lasts as long as millis.
+#define POWER_TIMER_COUNT TCNT0
+#define POWER_TICKS_PER_MS 256
+
+static uint32_t sleeps;
+static uint32_t asleep_ms;
+static uint8_t asleep_ticks;
+static uint32_t since_ms;
+
+static void idle_task(struct task* task);
+static bool sleep_once(void);
+
+void power_init(void) {
+  // Nothing uses the ADC, analog comparator, SPI or TWI
+  ACSR |= _BV(ACD);
+  PRR |= _BV(PRADC) | _BV(PRSPI) | _BV(PRTWI);
+  set_sleep_mode(POWER_SLEEP_MODE);
+
+  power_reset_stats();
+  // Not profiled, as it would be its own next deadline
+  struct task_config idle_task_config = { "pwidl", TASK_FOREVER, TASK_ASAP };
+  scheduler_add_task(&idle_task_config, idle_task, NULL);
+}
+
+// Runs on every pass of the scheduler loop and sleeps until the next
+// profiled task is due, going back to sleep after each millis tick.
+// Any other interrupt may have left work for the loop, such as a UART
+// byte or a finished DHT11 frame, so it ends the idle run early. With
+// nothing profiled scheduled it sleeps once.
+static void idle_task(struct task* task) {
+  uint32_t due;
+  bool scheduled = task_profile_next_due(&due);
+  do {
+    if (scheduled && (int32_t) (due - clock_get_millis()) <= 0) return;
+  } while (sleep_once() && scheduled);
+}
+
+// Sleeps until the next interrupt and adds the time to the stats; true
+// if millis moved on, which takes it to have been the tick that woke it
+static bool sleep_once(void) {
+  uint32_t start_ms;
+  uint8_t start_ticks;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    start_ms = clock_get_millis();
+    start_ticks = POWER_TIMER_COUNT;
+  }
+  // sei takes effect one instruction late, so an interrupt that comes
+  // in before the sleep instruction ends it at once instead of being
+  // missed
+  cli();
+  sleep_enable();
+  sei();
+  sleep_cpu();
+  sleep_disable();
+
+  uint32_t end_ms;
+  uint8_t end_ticks;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    end_ms = clock_get_millis();
+    end_ticks = POWER_TIMER_COUNT;
+  }
+  sleeps++;
+  uint32_t ticks = (end_ms - start_ms) * POWER_TICKS_PER_MS + end_ticks - start_ticks + asleep_ticks;
+  asleep_ms += ticks / POWER_TICKS_PER_MS;
+  asleep_ticks = ticks % POWER_TICKS_PER_MS;
+  return end_ms != start_ms;
+}
+
+// Awake is whatever of the time since the stats were reset was not
+// spent asleep
+void power_get_stats(struct power_stats* stats) {
+  uint32_t total = clock_get_millis() - since_ms;
+  stats->sleeps = sleeps;
+  stats->asleep_ms = asleep_ms;
+  stats->awake_ms = total > asleep_ms ? total - asleep_ms : 0;
+}
+
+void power_print_stats(FILE* stream) {
+  struct power_stats stats;
+  power_get_stats(&stats);
+  uint32_t total = stats.asleep_ms + stats.awake_ms;
+  uint16_t awake_permille = total >= 1000 ? stats.awake_ms / (total / 1000) : 0;
+  print_format_P(stream, WT_PGM_WETECTOR_SHELL_POWER, stats.sleeps, stats.asleep_ms, stats.awake_ms,
+    awake_permille / 10, awake_permille % 10);
+}
+
+void power_reset_stats(void) {
+  sleeps = 0;
+  asleep_ms = 0;
+  asleep_ticks = 0;
+  since_ms = clock_get_millis();
+}
@@ -0,0 +1,26 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "common.h"
+
+// Puts the MCU to sleep whenever no task is due, until one is or an
+// interrupt other than the millis tick comes in, and counts the time
+// spent asleep. The host build has a stand-in that never sleeps.
+void power_init(void);
+
+struct power_stats {
+  uint32_t sleeps;
+  uint32_t asleep_ms;
+  uint32_t awake_ms;
+};
+
+void power_get_stats(struct power_stats* stats);
+
+void power_print_stats(FILE* stream);
+
+void power_reset_stats(void);
+
+#endif
@@ -0,0 +1,86 @@
+#include <inttypes.h>
+#include <stdarg.h>
+#include <avr/pgmspace.h>
+
+#include "print.h"
+
+// Longest uint32_t in decimal
+#define PRINT_MAX_DIGITS 10
+
+void print_uint(FILE* stream, uint32_t value, uint8_t width) {
+  char digits[PRINT_MAX_DIGITS];
+  uint8_t count = 0;
+  // Only the digits above 16 bits need the slow 32-bit division
+  while (value > UINT16_MAX) {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  }
+  uint16_t low = value;
+  do {
+    digits[count++] = '0' + low % 10;
+    low /= 10;
+  } while (low > 0);
+  for (; width > count; width--) {
+    fputc('0', stream);
+  }
+  while (count > 0) {
+    fputc(digits[--count], stream);
+  }
+}
+
+void print_int(FILE* stream, int32_t value, uint8_t width) {
+  if (value < 0) {
+    fputc('-', stream);
+    print_uint(stream, -(uint32_t) value, width > 0 ? width - 1 : 0);
+  } else {
+    print_uint(stream, value, width);
+  }
+}
+
+void print_format_P(FILE* stream, PGM_P format, ...) {
+  va_list args;
+  va_start(args, format);
+  char c;
+  while ((c = pgm_read_byte(format++)) != '\0') {
+    if (c != '%') {
+      fputc(c, stream);
+      continue;
+    }
+    uint8_t width = 0;
+    bool is_long = false;
+    c = pgm_read_byte(format++);
+    while (c >= '0' && c <= '9') {
+      width = width * 10 + c - '0';
+      c = pgm_read_byte(format++);
+    }
+    if (c == 'l') {
+      is_long = true;
+      c = pgm_read_byte(format++);
+    }
+    switch (c) {
+    case 'u':
+      print_uint(stream, is_long ? va_arg(args, uint32_t) : va_arg(args, unsigned int), width);
+      break;
+    case 'i':
+    case 'd':
+      print_int(stream, is_long ? va_arg(args, int32_t) : va_arg(args, int), width);
+      break;
+    case 's':
+      fputs(va_arg(args, const char*), stream);
+      break;
+    case 'S':
+      fputs_P(va_arg(args, PGM_P), stream);
+      break;
+    case 'c':
+      fputc(va_arg(args, int), stream);
+      break;
+    case '\0':
+      format--;
+      break;
+    default:
+      fputc(c, stream);
+      break;
+    }
+  }
+  va_end(args);
+}
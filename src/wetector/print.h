@@ -0,0 +1,21 @@
+#ifndef PRINT_H
+#define PRINT_H
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <avr/pgmspace.h>
+
+#include "common.h"
+
+// Integer-only output, so the image doesn't need avr-libc's vfprintf
+// with float support. width pads with leading zeros, like %02u.
+void print_uint(FILE* stream, uint32_t value, uint8_t width);
+
+void print_int(FILE* stream, int32_t value, uint8_t width);
+
+// A printf for format strings in flash that knows %u, %i, %d, %s, %S
+// (a string in flash), %c and %%, with an optional zero-padded width
+// and an l for 32-bit arguments
+void print_format_P(FILE* stream, PGM_P format, ...);
+
+#endif
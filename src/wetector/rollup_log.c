@@ -0,0 +1,91 @@
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+#include "eeprom_writer.h"
+#include "rollup_log.h"
+
+// Not the sample log's, so that neither kind of slot passes as the other
+#define ROLLUP_LOG_CRC_SEED 0xA5
+
+_Static_assert(ROLLUP_LOG_START + (ROLLUP_LOG_HOUR_SLOTS + 1) * sizeof(struct rollup_record) <= E2END + 1,
+  "No room in the EEPROM for a day of hourly rollups");
+_Static_assert(ROLLUP_LOG_HOUR_SLOTS < 128 && ROLLUP_LOG_DAY_SLOTS < 128, "rollup seqs are compared as int8_t");
+
+static const uint8_t ring_slots[ROLLUP_LOG_KINDS] = { ROLLUP_LOG_HOUR_SLOTS, ROLLUP_LOG_DAY_SLOTS };
+static const uint8_t ring_first_slots[ROLLUP_LOG_KINDS] = { 0, ROLLUP_LOG_HOUR_SLOTS };
+
+static uint8_t head_slots[ROLLUP_LOG_KINDS];
+static uint8_t next_seqs[ROLLUP_LOG_KINDS];
+static bool empty[ROLLUP_LOG_KINDS];
+
+static bool read_record(uint8_t kind, uint8_t slot, struct rollup_record* record);
+static uint8_t record_crc(const struct rollup_record* record);
+static uint16_t slot_address(uint8_t kind, uint8_t slot);
+
+// Finds each ring's newest valid record
+void rollup_log_init(void) {
+  struct rollup_record record;
+  for (uint8_t kind = 0; kind < ROLLUP_LOG_KINDS; kind++) {
+    empty[kind] = true;
+    for (uint8_t slot = 0; slot < ring_slots[kind]; slot++) {
+      if (!read_record(kind, slot, &record)) continue;
+      if (empty[kind] || (int8_t) (record.seq - (next_seqs[kind] - 1)) > 0) {
+        head_slots[kind] = slot;
+        next_seqs[kind] = record.seq + 1;
+        empty[kind] = false;
+      }
+    }
+  }
+}
+
+uint8_t rollup_log_append(uint8_t kind, struct rollup_record* record) {
+  if (!rollup_log_ready()) return 0;
+
+  uint8_t slot = empty[kind] ? 0 : head_slots[kind] + 1;
+  if (slot == ring_slots[kind]) slot = 0;
+
+  record->seq = next_seqs[kind];
+  record->crc = record_crc(record);
+  eeprom_writer_write(slot_address(kind, slot), record, sizeof(*record));
+
+  head_slots[kind] = slot;
+  next_seqs[kind]++;
+  empty[kind] = false;
+  return sizeof(*record);
+}
+
+bool rollup_log_ready(void) {
+  return !eeprom_writer_busy();
+}
+
+// The record index slots back from the head, if it passes its CRC and
+// has the seq to match, so a torn or stale slot reads as a gap
+bool rollup_log_read(uint8_t kind, uint8_t index, struct rollup_record* record) {
+  if (empty[kind] || index >= ring_slots[kind]) return false;
+
+  int16_t slot = (int16_t) head_slots[kind] - index;
+  if (slot < 0) slot += ring_slots[kind];
+  return read_record(kind, slot, record) && record->seq == (uint8_t) (next_seqs[kind] - 1 - index);
+}
+
+static bool read_record(uint8_t kind, uint8_t slot, struct rollup_record* record) {
+  eeprom_writer_wait();
+  eeprom_read_block(record, (const void*) slot_address(kind, slot), sizeof(*record));
+  return record->crc == record_crc(record);
+}
+
+static uint8_t record_crc(const struct rollup_record* record) {
+  const uint8_t* bytes = (const uint8_t*) record;
+  uint8_t crc = ROLLUP_LOG_CRC_SEED;
+  for (uint8_t i = 0; i < offsetof(struct rollup_record, crc); i++) {
+    crc = _crc8_ccitt_update(crc, bytes[i]);
+  }
+  return crc;
+}
+
+static uint16_t slot_address(uint8_t kind, uint8_t slot) {
+  return ROLLUP_LOG_START + (ring_first_slots[kind] + slot) * sizeof(struct rollup_record);
+}
@@ -0,0 +1,55 @@
+#ifndef ROLLUP_LOG_H
+#define ROLLUP_LOG_H
+
+#include <inttypes.h>
+#include <avr/io.h>
+
+#include "common.h"
+#include "sample_log.h"
+#include "snapshot.h"
+
+// Hourly and daily records, each kind in a ring of its own past the
+// snapshot headers, so wrapping hours never push out a day and saves
+// and loads never touch either. As in the sample log, the head is the
+// slot with the newest seq whose record passes its CRC; seqs are a
+// byte, which is plenty for rings this short. The days take whatever
+// EEPROM the hours leave, 12 of them on the ATmega328. Both rings are
+// shared by all the sensors, each of which writes a record an hour and
+// a day, so with N sensors they go back 1/N as far: 24 hours and 12
+// days with one sensor, 12 hours and 6 days with two.
+#define ROLLUP_LOG_START SNAPSHOT_END
+#define ROLLUP_LOG_HOURS 0
+#define ROLLUP_LOG_DAYS 1
+#define ROLLUP_LOG_KINDS 2
+#define ROLLUP_LOG_HOUR_SLOTS 24
+
+// One hour or day of one sensor, numbered from device_seconds 0: the
+// lowest and highest window mean and the mean of all its samples,
+// rounded, for each channel. seq and crc are filled in by the log.
+struct rollup_record {
+  uint8_t seq;
+  uint8_t sensor;
+  uint16_t period;
+  uint8_t min[SAMPLE_LOG_CHANNELS];
+  uint8_t max[SAMPLE_LOG_CHANNELS];
+  uint8_t mean[SAMPLE_LOG_CHANNELS];
+  uint8_t crc;
+};
+
+#define ROLLUP_LOG_DAY_SLOTS ((E2END + 1 - ROLLUP_LOG_START) / sizeof(struct rollup_record) - ROLLUP_LOG_HOUR_SLOTS)
+#define ROLLUP_LOG_END (ROLLUP_LOG_START + (ROLLUP_LOG_HOUR_SLOTS + ROLLUP_LOG_DAY_SLOTS) * sizeof(struct rollup_record))
+
+void rollup_log_init(void);
+
+// Queues the record on the EEPROM writer and returns at once, or
+// returns 0 without writing it if rollup_log_ready is false
+uint8_t rollup_log_append(uint8_t kind, struct rollup_record* record);
+
+// Whether the EEPROM writer is free for an append, as a save may hold it
+bool rollup_log_ready(void);
+
+// Reads the index-th newest record of the kind, from 0; false past the
+// oldest, or if that slot was torn
+bool rollup_log_read(uint8_t kind, uint8_t index, struct rollup_record* record);
+
+#endif
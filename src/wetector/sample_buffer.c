@@ -1,72 +1,331 @@
 
 #include <inttypes.h>
 #include <stdio.h>
-#include <avr/eeprom.h>
 
+#include "print.h"
 #include "sample_buffer.h"
 
-void sample_buffer_init(struct sample_buffer* buffer, uint8_t* samples, const uint16_t size) {
+#define PRINT_SAMPLES_PER_LINE 25
+
+// Deltas are stored biased by this, so codes 0-14 are -7..+7
+#define DELTA_BIAS 7
+#define DELTA_KEY_NIBBLES 3
+
+static void print_separator(FILE* stream, uint16_t i, uint16_t count, uint8_t* column);
+static bool cursor_lost(const struct sample_cursor* cursor, uint16_t pushes);
+static void evict_oldest(struct delta_buffer* buffer);
+static uint8_t decode_next(const struct delta_buffer* buffer, struct delta_cursor* cursor, uint16_t evicted);
+static uint8_t decode_at(const struct delta_buffer* buffer, uint16_t pos, uint8_t previous);
+static uint8_t code_nibbles(const struct delta_buffer* buffer, uint16_t pos);
+static uint8_t nibble_at(const struct delta_buffer* buffer, uint16_t pos);
+static void put_nibble(struct delta_buffer* buffer, uint16_t pos, uint8_t nibble);
+
+void sample_buffer_init(struct sample_buffer* buffer, uint8_t* samples, uint8_t* valid, const uint16_t size) {
     buffer->size = size;
+    buffer->samples = samples;
+    buffer->valid = valid;
+    sample_buffer_clear(buffer);
+}
+
+void sample_buffer_clear(struct sample_buffer* buffer) {
+    buffer->pushes += buffer->size;
     buffer->start = 0;
     buffer->count = 0;
+    buffer->valid_count = 0;
     buffer->sum = 0;
-    buffer->samples = samples;
+    buffer->mean = 0;
+}
+
+void sample_buffer_refresh_mean(struct sample_buffer* buffer) {
+  if (buffer->valid_count > 0) {
+    buffer->mean = (buffer->sum << SAMPLE_BUFFER_MEAN_BITS) / buffer->valid_count;
+  }
 }
- 
-uint8_t sample_at(struct sample_buffer* buffer, uint16_t pos) {
-  uint16_t real_pos = (buffer->start + pos) % buffer->size;
-  return buffer->samples[real_pos];
+
+// Deviations are taken with half the mean's fractional bits, so their
+// squares come out with all of them in 24 bits and the sum of up to
+// 256 samples fits
+uint16_t sample_buffer_variance(const struct sample_buffer* buffer) {
+  if (buffer->valid_count < 2) return 0;
+
+  uint32_t sum = 0;
+  uint16_t real_pos = buffer->start;
+  for (uint16_t i = 0; i < buffer->count; i++) {
+    if (sample_valid_at(buffer, real_pos)) {
+      int16_t deviation = (((int32_t) buffer->samples[real_pos] << SAMPLE_BUFFER_MEAN_BITS) - buffer->mean)
+        >> (SAMPLE_BUFFER_MEAN_BITS / 2);
+      sum += (int32_t) deviation * deviation;
+    }
+    if (++real_pos == buffer->size) real_pos = 0;
+  }
+  uint32_t variance = sum / buffer->valid_count;
+  return variance > UINT16_MAX ? UINT16_MAX : variance;
 }
 
 void push_sample(struct sample_buffer* buffer, const uint8_t sample) {
-  if (buffer->count == buffer->size) {
-    buffer->sum -= buffer->samples[buffer->start];
+  sample_buffer_push_sized(buffer, buffer->size, sample, true);
+  sample_buffer_refresh_mean(buffer);
+}
+
+void print_sample_buffer(struct sample_buffer* buffer, FILE* stream) {
+  struct sample_cursor cursor;
+  sample_cursor_open(&cursor, buffer);
+  print_sample_buffer_chunk(buffer, &cursor, buffer->count, stream);
+}
+
+void sample_cursor_open(struct sample_cursor* cursor, const struct sample_buffer* buffer) {
+  cursor->pushes = buffer->pushes;
+  cursor->start = buffer->start;
+  cursor->count = buffer->count;
+  cursor->free = buffer->size - buffer->count;
+  cursor->next = 0;
+  cursor->column = 0;
+}
+
+bool print_sample_buffer_chunk(const struct sample_buffer* buffer, struct sample_cursor* cursor, uint16_t max, FILE* stream) {
+  uint16_t real_pos = sample_buffer_wrap(cursor->start + cursor->next, buffer->size);
+  for (; max > 0 && cursor->next < cursor->count; max--) {
+    if (cursor_lost(cursor, buffer->pushes)) {
+      fputs("..", stream);
+    } else if (sample_valid_at(buffer, real_pos)) {
+      print_uint(stream, buffer->samples[real_pos], 2);
+    } else {
+      fputs("--", stream);
+    }
+    if (++real_pos == buffer->size) real_pos = 0;
+    print_separator(stream, cursor->next++, cursor->count, &cursor->column);
   }
+  if (cursor->next < cursor->count) return true;
+  fputc('\n', stream);
+  fputc('\n', stream);
+  return false;
+}
 
-  uint16_t end = (buffer->start + buffer->count) % buffer->size;
-  buffer->samples[end] = sample;
-  buffer->sum += sample;
+void bucket_buffer_init(struct bucket_buffer* buffer, uint16_t* buckets, const uint8_t size, const uint8_t window) {
+  buffer->size = size;
+  buffer->window = window;
+  buffer->buckets = buckets;
+  bucket_buffer_clear(buffer);
+}
 
-  if (buffer->count == buffer->size) {
-    buffer->start = (buffer->start + 1) % buffer->size;      
-  } else {
-    buffer->count++;
+void bucket_buffer_clear(struct bucket_buffer* buffer) {
+  buffer->pushes += buffer->size;
+  buffer->start = 0;
+  buffer->count = 0;
+  buffer->pending = 0;
+  buffer->sum = 0;
+  buffer->mean = 0;
+}
+
+void bucket_buffer_refresh_mean(struct bucket_buffer* buffer) {
+  if (buffer->count > 0) {
+    buffer->mean = (buffer->sum << SAMPLE_BUFFER_MEAN_BITS) / ((uint16_t) buffer->count * buffer->window);
   }
 }
 
-void eeprom_read_buffer(struct sample_buffer* buffer, uint16_t pos) {
-  eeprom_busy_wait();
-  uint16_t length = eeprom_read_word((uint16_t*) pos);
-  pos += 2;
-  
-  for (uint16_t i = 0; i < length; i++) {
-    eeprom_busy_wait();  
-    push_sample(buffer, eeprom_read_byte((uint8_t*) pos + i));
+// Buckets print as the rounded mean of their window, in the same
+// layout as print_sample_buffer
+void print_bucket_buffer(struct bucket_buffer* buffer, FILE* stream) {
+  struct bucket_cursor cursor;
+  bucket_cursor_open(&cursor, buffer);
+  print_bucket_buffer_chunk(buffer, &cursor, buffer->count, stream);
+}
+
+void bucket_cursor_open(struct bucket_cursor* cursor, const struct bucket_buffer* buffer) {
+  struct sample_cursor* super = &cursor->super;
+  super->pushes = buffer->pushes;
+  super->start = buffer->start;
+  super->count = buffer->count;
+  super->free = buffer->size - buffer->count;
+  super->next = 0;
+  super->column = 0;
+  for (uint8_t i = 0; i < BUCKET_CURSOR_HEADS && i < buffer->count; i++) {
+    cursor->heads[i] = bucket_at(buffer, i);
   }
 }
 
-void eeprom_write_buffer(struct sample_buffer* buffer, uint16_t pos) {
-  eeprom_busy_wait();
-  eeprom_update_word((uint16_t*) pos, buffer->count);
-  pos += 2;
-  
-  for (uint16_t i = 0; i < buffer->count; i++) {
-    eeprom_busy_wait();  
-    eeprom_update_byte((uint8_t*) pos + i, sample_at(buffer, i));
+// A bucket pushed out before its turn prints from the cursor's copy if
+// it was one of the heads, or as ".." if not
+bool print_bucket_buffer_chunk(const struct bucket_buffer* buffer, struct bucket_cursor* cursor, uint16_t max, FILE* stream) {
+  struct sample_cursor* super = &cursor->super;
+  uint8_t real_pos = sample_buffer_wrap(super->start + super->next, buffer->size);
+  for (; max > 0 && super->next < super->count; max--) {
+    uint16_t bucket = buffer->buckets[real_pos];
+    bool lost = cursor_lost(super, buffer->pushes);
+    if (lost && super->next < BUCKET_CURSOR_HEADS) {
+      bucket = cursor->heads[super->next];
+      lost = false;
+    }
+    if (lost) {
+      fputs("..", stream);
+    } else {
+      print_uint(stream, (bucket + (buffer->window >> 1)) / buffer->window, 2);
+    }
+    if (++real_pos == buffer->size) real_pos = 0;
+    print_separator(stream, super->next++, super->count, &super->column);
   }
+  if (super->next < super->count) return true;
+  fputc('\n', stream);
+  fputc('\n', stream);
+  return false;
 }
 
-void print_sample_buffer(struct sample_buffer* buffer, FILE* stream) {
-  for (uint16_t i = 0; i < buffer->count; i++) {
-    fprintf(stream, "%02u", sample_at(buffer, i));
-    if (i + 1 < buffer->count) {
-      fputc(' ', stream);      
+void delta_buffer_init(struct delta_buffer* buffer, uint8_t* nibbles, const uint16_t bytes) {
+  buffer->size = bytes * 2;
+  buffer->nibbles = nibbles;
+  delta_buffer_clear(buffer);
+}
+
+// Cleared samples count as evicted, so open cursors show them as lost
+void delta_buffer_clear(struct delta_buffer* buffer) {
+  buffer->evictions += buffer->count;
+  buffer->tail = 0;
+  buffer->used = 0;
+  buffer->count = 0;
+  buffer->valid_count = 0;
+  buffer->sum = 0;
+  buffer->since_key = 0;
+}
+
+void delta_buffer_push(struct delta_buffer* buffer, const uint8_t sample) {
+  int16_t delta = (int16_t) sample - buffer->newest;
+  bool key = buffer->count == 0
+    || buffer->since_key >= DELTA_BUFFER_KEY_INTERVAL
+    || sample == DELTA_BUFFER_INVALID
+    || buffer->newest == DELTA_BUFFER_INVALID
+    || delta < -DELTA_BIAS || delta > DELTA_BIAS;
+  uint8_t nibbles = key ? DELTA_KEY_NIBBLES : 1;
+  while (buffer->size - buffer->used < nibbles) {
+    evict_oldest(buffer);
+  }
+
+  uint16_t pos = sample_buffer_wrap(buffer->tail + buffer->used, buffer->size);
+  if (key) {
+    put_nibble(buffer, pos, DELTA_BUFFER_ESCAPE);
+    pos = sample_buffer_wrap(pos + 1, buffer->size);
+    put_nibble(buffer, pos, sample >> 4);
+    pos = sample_buffer_wrap(pos + 1, buffer->size);
+    put_nibble(buffer, pos, sample & 0x0F);
+    buffer->since_key = 0;
+  } else {
+    put_nibble(buffer, pos, delta + DELTA_BIAS);
+    buffer->since_key++;
+  }
+  buffer->used += nibbles;
+
+  if (buffer->count++ == 0) {
+    buffer->oldest = sample;
+  }
+  buffer->newest = sample;
+  if (sample != DELTA_BUFFER_INVALID) {
+    buffer->sum += sample;
+    buffer->valid_count++;
+  }
+}
+
+// The new oldest sample is decoded from the one it replaces, so the
+// buffer never has to walk back to a key
+static void evict_oldest(struct delta_buffer* buffer) {
+  if (buffer->oldest != DELTA_BUFFER_INVALID) {
+    buffer->sum -= buffer->oldest;
+    buffer->valid_count--;
+  }
+  uint8_t nibbles = code_nibbles(buffer, buffer->tail);
+  buffer->tail = sample_buffer_wrap(buffer->tail + nibbles, buffer->size);
+  buffer->used -= nibbles;
+  buffer->evictions++;
+  if (--buffer->count > 0) {
+    buffer->oldest = decode_at(buffer, buffer->tail, buffer->oldest);
+  }
+}
+
+void print_delta_buffer(struct delta_buffer* buffer, FILE* stream) {
+  struct delta_cursor cursor;
+  delta_cursor_open(&cursor, buffer);
+  print_delta_buffer_chunk(buffer, &cursor, buffer->count, stream);
+}
+
+void delta_cursor_open(struct delta_cursor* cursor, const struct delta_buffer* buffer) {
+  cursor->evictions = buffer->evictions;
+  cursor->pos = buffer->tail;
+  cursor->count = buffer->count;
+  cursor->next = 0;
+  cursor->column = 0;
+}
+
+bool print_delta_buffer_chunk(const struct delta_buffer* buffer, struct delta_cursor* cursor, uint16_t max, FILE* stream) {
+  for (; max > 0 && cursor->next < cursor->count; max--) {
+    uint16_t evicted = buffer->evictions - cursor->evictions;
+    if (evicted > cursor->next) {
+      fputs("..", stream);
+    } else {
+      uint8_t sample = decode_next(buffer, cursor, evicted);
+      if (sample == DELTA_BUFFER_INVALID) {
+        fputs("--", stream);
+      } else {
+        print_uint(stream, sample, 2);
+      }
     }
-    if ((i + 1) % 25 == 0) {
-      fputc('\n', stream);
-    }    
+    print_separator(stream, cursor->next++, cursor->count, &cursor->column);
   }
+  if (cursor->next < cursor->count) return true;
   fputc('\n', stream);
   fputc('\n', stream);
+  return false;
 }
 
+// The cursor's next sample is the buffer's oldest once everything before
+// it has been evicted, and then its code may be a delta from a sample
+// that is gone
+static uint8_t decode_next(const struct delta_buffer* buffer, struct delta_cursor* cursor, uint16_t evicted) {
+  if (evicted == cursor->next) {
+    cursor->pos = buffer->tail;
+    cursor->value = buffer->oldest;
+  } else {
+    cursor->value = decode_at(buffer, cursor->pos, cursor->value);
+  }
+  cursor->pos = sample_buffer_wrap(cursor->pos + code_nibbles(buffer, cursor->pos), buffer->size);
+  return cursor->value;
+}
+
+static uint8_t decode_at(const struct delta_buffer* buffer, uint16_t pos, uint8_t previous) {
+  uint8_t code = nibble_at(buffer, pos);
+  if (code != DELTA_BUFFER_ESCAPE) return previous + code - DELTA_BIAS;
+  uint8_t high = nibble_at(buffer, sample_buffer_wrap(pos + 1, buffer->size));
+  return (high << 4) | nibble_at(buffer, sample_buffer_wrap(pos + 2, buffer->size));
+}
+
+static uint8_t code_nibbles(const struct delta_buffer* buffer, uint16_t pos) {
+  return nibble_at(buffer, pos) == DELTA_BUFFER_ESCAPE ? DELTA_KEY_NIBBLES : 1;
+}
+
+// Even nibbles are the low half of their byte
+static uint8_t nibble_at(const struct delta_buffer* buffer, uint16_t pos) {
+  uint8_t byte = buffer->nibbles[pos >> 1];
+  return pos & 1 ? byte >> 4 : byte & 0x0F;
+}
+
+static void put_nibble(struct delta_buffer* buffer, uint16_t pos, uint8_t nibble) {
+  uint8_t* byte = &buffer->nibbles[pos >> 1];
+  if (pos & 1) {
+    *byte = (*byte & 0x0F) | (nibble << 4);
+  } else {
+    *byte = (*byte & 0xF0) | nibble;
+  }
+}
+
+static void print_separator(FILE* stream, uint16_t i, uint16_t count, uint8_t* column) {
+  if (i + 1 < count) {
+    fputc(' ', stream);
+  }
+  if (++(*column) == PRINT_SAMPLES_PER_LINE) {
+    fputc('\n', stream);
+    *column = 0;
+  }
+}
+
+// Each push past the free slots the buffer had when the cursor was
+// opened has overwritten the oldest of the cursor's samples
+static bool cursor_lost(const struct sample_cursor* cursor, uint16_t pushes) {
+  return (uint16_t) (pushes - cursor->pushes) > cursor->free + cursor->next;
+}
@@ -2,24 +2,304 @@
 #define SAMPLE_BUFFER_H
 
 #include <inttypes.h>
+#include <stdbool.h>
 #include <stdio.h>
 
+// Cached means are fixed point with this many fractional bits
+#define SAMPLE_BUFFER_MEAN_BITS 8
+
+// 2^24 / SIZE rounded up: sum * reciprocal >> 16 is sum / SIZE with
+// SAMPLE_BUFFER_MEAN_BITS fractional bits, and 255 * SIZE * reciprocal
+// always fits in 32 bits
+#define SAMPLE_BUFFER_RECIPROCAL(SIZE) (((1UL << 24) + (SIZE) - 1) / (SIZE))
+
+// Slots can hold a failed reading: the valid bitmap has one bit per
+// slot and sum and mean cover the valid samples only. With no valid
+// samples the mean holds its last value. pushes only ever counts up
+// (a clear counts as a lap of the ring), for sample_cursor.
 struct sample_buffer {
   uint16_t size;
   uint16_t start;
   uint16_t count;
+  uint16_t valid_count;
+  uint16_t pushes;
   uint32_t sum;
+  uint16_t mean;
   uint8_t* samples;
+  uint8_t* valid;
 };
 
-void sample_buffer_init(struct sample_buffer* buffer, uint8_t* samples, const uint16_t size);
+#define SAMPLE_BUFFER_VALID_BYTES(SIZE) (((SIZE) + 7) >> 3)
 
-void push_sample(struct sample_buffer* buffer, const uint8_t sample);
+// Where a print spread over several calls has got to. It covers the
+// samples the buffer held when the cursor was opened; any of those
+// pushed out of the ring before their turn print as "..".
+struct sample_cursor {
+  uint16_t pushes;
+  uint16_t start;
+  uint16_t count;
+  uint16_t free;
+  uint16_t next;
+  uint8_t column;
+};
+
+// Ring of window sums rolled up from a sample_buffer whose size is the
+// window: each time the source has taken a full window of new samples
+// its sum becomes one bucket, so size buckets cover size * window
+// samples at two bytes per window
+struct bucket_buffer {
+  uint8_t size;
+  uint8_t window;
+  uint8_t start;
+  uint8_t count;
+  uint8_t pending;
+  uint16_t pushes;
+  uint32_t sum;
+  uint16_t mean;
+  uint16_t* buckets;
+};
+
+// A sample_cursor over a bucket_buffer that also keeps the oldest
+// BUCKET_CURSOR_HEADS buckets as they were when it was opened. Those
+// are the ones pushes overwrite first, and a bucket takes a whole
+// window to fill, so a print that takes less than that many windows
+// shows every bucket.
+#define BUCKET_CURSOR_HEADS 2
+
+struct bucket_cursor {
+  struct sample_cursor super;
+  uint16_t heads[BUCKET_CURSOR_HEADS];
+};
+
+// Samples stored as 4-bit deltas, for long raw histories of readings
+// that move slowly. A code of 0-14 is the sample before plus -7..+7;
+// DELTA_BUFFER_ESCAPE is followed by the whole sample in two nibbles,
+// high first, and is used for bigger steps, failed readings and the
+// sample after one, and every DELTA_BUFFER_KEY_INTERVAL
+// samples as a key, so a copy of the codes can be decoded from the
+// next key on. The ring keeps as many of the newest samples as fit, so
+// count depends on how much the readings move: a smooth history takes
+// a little over four bits a sample against sample_buffer's nine. A
+// push evicts at most three samples, and sum covers the valid samples
+// as in sample_buffer. Failed readings are stored as
+// DELTA_BUFFER_INVALID, which no real sample may take. Cursors only
+// print: nothing writes a delta_buffer to the EEPROM, so hum_temp's
+// histories are lost on a reset and start empty after a warm start.
+struct delta_buffer {
+  uint16_t size;
+  uint16_t tail;
+  uint16_t used;
+  uint16_t count;
+  uint16_t valid_count;
+  uint16_t evictions;
+  uint32_t sum;
+  uint8_t oldest;
+  uint8_t newest;
+  uint8_t since_key;
+  uint8_t* nibbles;
+};
+
+#define DELTA_BUFFER_INVALID 0xFF
+#define DELTA_BUFFER_ESCAPE 15
+#define DELTA_BUFFER_KEY_INTERVAL 64
+
+// A walk through a delta_buffer, oldest first, over the samples it held
+// when the cursor was opened. The oldest sample's value is kept by the
+// buffer, so a cursor that pushes have overtaken picks up again at the
+// new oldest; print shows the evicted samples as "..".
+struct delta_cursor {
+  uint16_t evictions;
+  uint16_t pos;
+  uint16_t count;
+  uint16_t next;
+  uint8_t value;
+  uint8_t column;
+};
+
+// Declares struct sample_buffer_<SIZE>, with its storage inline, and
+// sample_buffer_<SIZE>_init/_push/_push_invalid/_copy. SIZE is a constant in
+// the generated push, so the ring wraps with a mask (powers of two) or
+// a compare against an immediate rather than a runtime 16-bit modulo,
+// and once every slot holds a valid sample the cached mean is a
+// multiply by the reciprocal of SIZE. The embedded super buffer keeps
+// the generic functions below working.
+#define SAMPLE_BUFFER_DEFINE(SIZE) \
+struct sample_buffer_ ## SIZE { \
+  struct sample_buffer super; \
+  uint8_t samples[SIZE]; \
+  uint8_t valid[SAMPLE_BUFFER_VALID_BYTES(SIZE)]; \
+}; \
+static inline void sample_buffer_ ## SIZE ## _init(struct sample_buffer_ ## SIZE* buffer) { \
+  sample_buffer_init(&buffer->super, buffer->samples, buffer->valid, SIZE); \
+} \
+static inline void sample_buffer_ ## SIZE ## _update_mean(struct sample_buffer_ ## SIZE* buffer) { \
+  if (buffer->super.valid_count == SIZE) { \
+    buffer->super.mean = (buffer->super.sum * SAMPLE_BUFFER_RECIPROCAL(SIZE)) >> 16; \
+  } else { \
+    sample_buffer_refresh_mean(&buffer->super); \
+  } \
+} \
+static inline void sample_buffer_ ## SIZE ## _push(struct sample_buffer_ ## SIZE* buffer, const uint8_t sample) { \
+  sample_buffer_push_sized(&buffer->super, SIZE, sample, true); \
+  sample_buffer_ ## SIZE ## _update_mean(buffer); \
+} \
+static inline void sample_buffer_ ## SIZE ## _push_invalid(struct sample_buffer_ ## SIZE* buffer) { \
+  sample_buffer_push_sized(&buffer->super, SIZE, 0, false); \
+  sample_buffer_ ## SIZE ## _update_mean(buffer); \
+} \
+static inline void sample_buffer_ ## SIZE ## _copy(struct sample_buffer_ ## SIZE* to, const struct sample_buffer_ ## SIZE* from) { \
+  *to = *from; \
+  to->super.samples = to->samples; \
+  to->super.valid = to->valid; \
+}
+
+// Declares struct bucket_buffer_<SIZE> and bucket_buffer_<SIZE>_init,
+// _push (one window sum) and _roll (call after every push to the
+// source; true when it completed a window). A window with failed
+// readings rolls up as its valid mean times WINDOW, and one with none
+// is dropped. The mean has the same fixed point as sample_buffer's, is
+// reciprocal-multiplied once full and follows the source's mean until
+// the first window completes.
+#define BUCKET_BUFFER_DEFINE(SIZE, WINDOW) \
+struct bucket_buffer_ ## SIZE { \
+  struct bucket_buffer super; \
+  uint16_t buckets[SIZE]; \
+}; \
+static inline void bucket_buffer_ ## SIZE ## _init(struct bucket_buffer_ ## SIZE* buffer) { \
+  bucket_buffer_init(&buffer->super, buffer->buckets, SIZE, WINDOW); \
+} \
+static inline void bucket_buffer_ ## SIZE ## _push(struct bucket_buffer_ ## SIZE* buffer, const uint16_t bucket) { \
+  bucket_buffer_push_sized(&buffer->super, SIZE, bucket); \
+  if (buffer->super.count == SIZE) { \
+    buffer->super.mean = (buffer->super.sum * SAMPLE_BUFFER_RECIPROCAL((SIZE) * (WINDOW))) >> 16; \
+  } else { \
+    bucket_buffer_refresh_mean(&buffer->super); \
+  } \
+} \
+static inline bool bucket_buffer_ ## SIZE ## _roll(struct bucket_buffer_ ## SIZE* buffer, const struct sample_buffer* source) { \
+  if (buffer->super.count == 0) { \
+    buffer->super.mean = source->mean; \
+  } \
+  if (++buffer->super.pending < WINDOW) return false; \
+  buffer->super.pending = 0; \
+  if (source->valid_count == WINDOW) { \
+    bucket_buffer_ ## SIZE ## _push(buffer, source->sum); \
+  } else if (source->valid_count > 0) { \
+    bucket_buffer_ ## SIZE ## _push(buffer, ((uint32_t) source->mean * (WINDOW) + (1 << (SAMPLE_BUFFER_MEAN_BITS - 1))) >> SAMPLE_BUFFER_MEAN_BITS); \
+  } else { \
+    return false; \
+  } \
+  return true; \
+}
+
+// Declares struct delta_buffer_<BYTES>, with BYTES (at least 2) of
+// codes inline, and delta_buffer_<BYTES>_init
+#define DELTA_BUFFER_DEFINE(BYTES) \
+struct delta_buffer_ ## BYTES { \
+  struct delta_buffer super; \
+  uint8_t nibbles[BYTES]; \
+}; \
+static inline void delta_buffer_ ## BYTES ## _init(struct delta_buffer_ ## BYTES* buffer) { \
+  delta_buffer_init(&buffer->super, buffer->nibbles, BYTES); \
+}
 
-void eeprom_read_buffer(struct sample_buffer* buffer, uint16_t pos);
+static inline uint16_t sample_buffer_wrap(const uint16_t pos, const uint16_t size) __attribute__((always_inline));
+static inline uint16_t sample_buffer_wrap(const uint16_t pos, const uint16_t size) {
+  if ((size & (size - 1)) == 0) return pos & (size - 1);
+  return pos >= size ? pos - size : pos;
+}
 
-void eeprom_write_buffer(struct sample_buffer* buffer, uint16_t pos);
+static inline void sample_buffer_push_sized(struct sample_buffer* buffer, const uint16_t size, const uint8_t sample, const bool valid) __attribute__((always_inline));
+static inline void sample_buffer_push_sized(struct sample_buffer* buffer, const uint16_t size, const uint8_t sample, const bool valid) {
+  uint16_t end = sample_buffer_wrap(buffer->start + buffer->count, size);
+  uint8_t* valid_bits = &buffer->valid[end >> 3];
+  uint8_t valid_mask = 1 << (end & 7);
+  if (buffer->count == size) {
+    if (*valid_bits & valid_mask) {
+      buffer->sum -= buffer->samples[end];
+      buffer->valid_count--;
+    }
+    buffer->start = sample_buffer_wrap(buffer->start + 1, size);
+  } else {
+    buffer->count++;
+  }
+  buffer->samples[end] = sample;
+  buffer->pushes++;
+  if (valid) {
+    *valid_bits |= valid_mask;
+    buffer->sum += sample;
+    buffer->valid_count++;
+  } else {
+    *valid_bits &= ~valid_mask;
+  }
+}
+
+static inline bool sample_valid_at(const struct sample_buffer* buffer, const uint16_t real_pos) {
+  return buffer->valid[real_pos >> 3] & (1 << (real_pos & 7));
+}
+
+static inline void bucket_buffer_push_sized(struct bucket_buffer* buffer, const uint8_t size, const uint16_t bucket) __attribute__((always_inline));
+static inline void bucket_buffer_push_sized(struct bucket_buffer* buffer, const uint8_t size, const uint16_t bucket) {
+  uint8_t end = sample_buffer_wrap(buffer->start + buffer->count, size);
+  if (buffer->count == size) {
+    buffer->sum -= buffer->buckets[end];
+    buffer->start = sample_buffer_wrap(buffer->start + 1, size);
+  } else {
+    buffer->count++;
+  }
+  buffer->buckets[end] = bucket;
+  buffer->sum += bucket;
+  buffer->pushes++;
+}
+
+static inline uint16_t bucket_at(const struct bucket_buffer* buffer, const uint8_t pos) {
+  return buffer->buckets[sample_buffer_wrap(buffer->start + pos, buffer->size)];
+}
+
+void sample_buffer_init(struct sample_buffer* buffer, uint8_t* samples, uint8_t* valid, const uint16_t size);
+
+void sample_buffer_clear(struct sample_buffer* buffer);
+
+void sample_buffer_refresh_mean(struct sample_buffer* buffer);
+
+// Variance of the valid samples about the cached mean, fixed point
+// like the mean and capped at UINT16_MAX; 0 with fewer than two
+uint16_t sample_buffer_variance(const struct sample_buffer* buffer);
+
+void push_sample(struct sample_buffer* buffer, const uint8_t sample);
 
 void print_sample_buffer(struct sample_buffer* buffer, FILE* stream);
 
+void sample_cursor_open(struct sample_cursor* cursor, const struct sample_buffer* buffer);
+
+// Prints up to max samples in print_sample_buffer's layout. Returns
+// true while there are more to come; the call that prints the last
+// one ends the block and returns false.
+bool print_sample_buffer_chunk(const struct sample_buffer* buffer, struct sample_cursor* cursor, uint16_t max, FILE* stream);
+
+void bucket_buffer_init(struct bucket_buffer* buffer, uint16_t* buckets, const uint8_t size, const uint8_t window);
+
+void bucket_buffer_clear(struct bucket_buffer* buffer);
+
+void bucket_buffer_refresh_mean(struct bucket_buffer* buffer);
+
+void print_bucket_buffer(struct bucket_buffer* buffer, FILE* stream);
+
+void bucket_cursor_open(struct bucket_cursor* cursor, const struct bucket_buffer* buffer);
+
+bool print_bucket_buffer_chunk(const struct bucket_buffer* buffer, struct bucket_cursor* cursor, uint16_t max, FILE* stream);
+
+void delta_buffer_init(struct delta_buffer* buffer, uint8_t* nibbles, const uint16_t bytes);
+
+void delta_buffer_clear(struct delta_buffer* buffer);
+
+// Pushes a sample, or DELTA_BUFFER_INVALID for a failed reading
+void delta_buffer_push(struct delta_buffer* buffer, const uint8_t sample);
+
+void print_delta_buffer(struct delta_buffer* buffer, FILE* stream);
+
+void delta_cursor_open(struct delta_cursor* cursor, const struct delta_buffer* buffer);
+
+bool print_delta_buffer_chunk(const struct delta_buffer* buffer, struct delta_cursor* cursor, uint16_t max, FILE* stream);
+
 #endif
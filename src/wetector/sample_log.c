@@ -0,0 +1,124 @@
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+#include "eeprom_writer.h"
+#include "sample_log.h"
+
+// Non-zero so that neither erased (0xFF) nor zeroed slots pass the CRC
+#define SAMPLE_LOG_CRC_SEED 0x5A
+
+static uint8_t head_slot;
+static uint16_t next_seq;
+static uint8_t run_length;
+static bool empty;
+
+static uint8_t measure_run(uint8_t max_entries, uint8_t* oldest_slot);
+static bool read_entry(uint8_t slot, struct sample_log_entry* entry);
+static uint8_t entry_crc(const struct sample_log_entry* entry);
+static uint16_t slot_address(uint8_t slot);
+
+// Finds the newest valid entry; erased or torn slots fail their CRC
+void sample_log_init(void) {
+  struct sample_log_entry entry;
+  empty = true;
+  for (uint8_t slot = 0; slot < SAMPLE_LOG_SLOTS; slot++) {
+    if (!read_entry(slot, &entry)) continue;
+    if (empty || (int16_t) (entry.seq - (next_seq - 1)) > 0) {
+      head_slot = slot;
+      next_seq = entry.seq + 1;
+      empty = false;
+    }
+  }
+
+  uint8_t oldest_slot;
+  run_length = empty ? 0 : measure_run(SAMPLE_LOG_SLOTS, &oldest_slot);
+}
+
+// Queues the entry on the EEPROM writer and returns at once; the next
+// append has to wait until sample_log_ready
+uint16_t sample_log_append(struct sample_log_entry* entry) {
+  if (!sample_log_ready()) return 0;
+
+  uint8_t slot = empty ? 0 : head_slot + 1;
+  if (slot == SAMPLE_LOG_SLOTS) slot = 0;
+
+  entry->seq = next_seq;
+  entry->crc = entry_crc(entry);
+  eeprom_writer_write(slot_address(slot), entry, sizeof(*entry));
+
+  head_slot = slot;
+  next_seq++;
+  if (run_length < SAMPLE_LOG_SLOTS) {
+    run_length++;
+  }
+  empty = false;
+  return sizeof(*entry);
+}
+
+bool sample_log_ready(void) {
+  return !eeprom_writer_busy();
+}
+
+bool sample_log_head_seq(uint16_t* seq) {
+  *seq = next_seq - 1;
+  return !empty;
+}
+
+// Number of entries in the newest unbroken run, i.e. what a replay with
+// no limit would visit
+uint8_t sample_log_run_length(void) {
+  return run_length;
+}
+
+// Visits up to max_entries of the newest unbroken run of entries,
+// oldest first, and returns how many were visited
+uint8_t sample_log_replay(uint8_t max_entries, sample_log_visitor visit) {
+  if (empty) return 0;
+
+  struct sample_log_entry entry;
+  uint8_t slot;
+  uint8_t length = measure_run(max_entries, &slot);
+  for (uint8_t i = 0; i < length; i++) {
+    read_entry(slot, &entry);
+    visit(&entry);
+    if (++slot == SAMPLE_LOG_SLOTS) slot = 0;
+  }
+  return length;
+}
+
+// Walks back from the head while the seqs stay consecutive and returns
+// the run length, up to max_entries, and the slot the run starts at
+static uint8_t measure_run(uint8_t max_entries, uint8_t* oldest_slot) {
+  struct sample_log_entry entry;
+  uint8_t slot = head_slot;
+  uint8_t length = 0;
+  while (length < max_entries && length < SAMPLE_LOG_SLOTS && read_entry(slot, &entry)
+      && entry.seq == (uint16_t) (next_seq - 1 - length)) {
+    length++;
+    *oldest_slot = slot;
+    slot = (slot == 0 ? SAMPLE_LOG_SLOTS : slot) - 1;
+  }
+  return length;
+}
+
+static bool read_entry(uint8_t slot, struct sample_log_entry* entry) {
+  eeprom_writer_wait();
+  eeprom_read_block(entry, (const void*) slot_address(slot), sizeof(*entry));
+  return entry->crc == entry_crc(entry);
+}
+
+static uint8_t entry_crc(const struct sample_log_entry* entry) {
+  const uint8_t* bytes = (const uint8_t*) entry;
+  uint8_t crc = SAMPLE_LOG_CRC_SEED;
+  for (uint8_t i = 0; i < offsetof(struct sample_log_entry, crc); i++) {
+    crc = _crc8_ccitt_update(crc, bytes[i]);
+  }
+  return crc;
+}
+
+static uint16_t slot_address(uint8_t slot) {
+  return SAMPLE_LOG_START + slot * sizeof(struct sample_log_entry);
+}
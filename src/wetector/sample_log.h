@@ -0,0 +1,42 @@
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+
+#include <inttypes.h>
+
+#include "common.h"
+
+// The log is a ring of fixed size entries in EEPROM. Appends go to the
+// slot after the newest entry, so every slot is written once per lap
+// of the ring instead of on every save.
+#define SAMPLE_LOG_START 0
+#define SAMPLE_LOG_SLOTS 64
+#define SAMPLE_LOG_CHANNELS 2
+
+// One rolled up window of one sensor: the sum of each channel's
+// samples and the number of samples summed. seq and crc are filled in
+// by the log.
+struct sample_log_entry {
+  uint16_t seq;
+  uint16_t sums[SAMPLE_LOG_CHANNELS];
+  uint8_t sensor;
+  uint8_t samples;
+  uint8_t crc;
+};
+
+#define SAMPLE_LOG_END (SAMPLE_LOG_START + SAMPLE_LOG_SLOTS * sizeof(struct sample_log_entry))
+
+typedef void (*sample_log_visitor)(const struct sample_log_entry* entry);
+
+void sample_log_init(void);
+
+uint16_t sample_log_append(struct sample_log_entry* entry);
+
+bool sample_log_ready(void);
+
+bool sample_log_head_seq(uint16_t* seq);
+
+uint8_t sample_log_run_length(void);
+
+uint8_t sample_log_replay(uint8_t max_entries, sample_log_visitor visit);
+
+#endif
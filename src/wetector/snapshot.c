@@ -0,0 +1,71 @@
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+#include "eeprom_writer.h"
+#include "snapshot.h"
+
+#define SNAPSHOT_CRC_SEED 0xFFFF
+
+static uint8_t newest_slot(struct snapshot* snapshot);
+static bool read_slot(uint8_t slot, struct snapshot* snapshot);
+static uint16_t snapshot_crc(const struct snapshot* snapshot);
+static uint16_t slot_address(uint8_t slot);
+
+bool snapshot_read(struct snapshot* snapshot) {
+  return newest_slot(snapshot) < SNAPSHOT_SLOTS;
+}
+
+// Queues the header on the EEPROM writer in the slot after the newest
+// one; callers wait for eeprom_writer_busy to clear before relying on it
+uint16_t snapshot_write(struct snapshot* snapshot) {
+  struct snapshot newest;
+  uint8_t slot = newest_slot(&newest);
+  if (slot < SNAPSHOT_SLOTS) {
+    snapshot->generation = newest.generation + 1;
+    if (++slot == SNAPSHOT_SLOTS) slot = 0;
+  } else {
+    snapshot->generation = 0;
+    slot = 0;
+  }
+
+  snapshot->version = SNAPSHOT_VERSION;
+  snapshot->crc = snapshot_crc(snapshot);
+  return eeprom_writer_write(slot_address(slot), snapshot, sizeof(*snapshot));
+}
+
+// Finds the valid header of the current version with the latest
+// generation; returns SNAPSHOT_SLOTS when there is none
+static uint8_t newest_slot(struct snapshot* snapshot) {
+  struct snapshot candidate;
+  uint8_t newest = SNAPSHOT_SLOTS;
+  for (uint8_t slot = 0; slot < SNAPSHOT_SLOTS; slot++) {
+    if (!read_slot(slot, &candidate)) continue;
+    if (newest == SNAPSHOT_SLOTS || (int8_t) (candidate.generation - snapshot->generation) > 0) {
+      *snapshot = candidate;
+      newest = slot;
+    }
+  }
+  return newest;
+}
+
+static bool read_slot(uint8_t slot, struct snapshot* snapshot) {
+  eeprom_writer_wait();
+  eeprom_read_block(snapshot, (const void*) slot_address(slot), sizeof(*snapshot));
+  return snapshot->version == SNAPSHOT_VERSION && snapshot->crc == snapshot_crc(snapshot);
+}
+
+static uint16_t snapshot_crc(const struct snapshot* snapshot) {
+  const uint8_t* bytes = (const uint8_t*) snapshot;
+  uint16_t crc = SNAPSHOT_CRC_SEED;
+  for (uint8_t i = 0; i < offsetof(struct snapshot, crc); i++) {
+    crc = _crc16_update(crc, bytes[i]);
+  }
+  return crc;
+}
+
+static uint16_t slot_address(uint8_t slot) {
+  return SNAPSHOT_START + slot * sizeof(struct snapshot);
+}
@@ -0,0 +1,35 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <inttypes.h>
+
+#include "common.h"
+#include "sample_log.h"
+
+// Snapshot headers live in a small ring of their own just past the
+// sample log, so rewriting one on every save wears SNAPSHOT_SLOTS
+// times slower. Bump SNAPSHOT_VERSION whenever the layout of the
+// header or of sample_log_entry changes.
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_START SAMPLE_LOG_END
+#define SNAPSHOT_SLOTS 4
+
+// Describes the run of log entries a save left behind: the newest
+// entry's seq and how many windows lead up to it. saved_at is the
+// device clock in seconds, which carries on across restarts.
+struct snapshot {
+  uint8_t version;
+  uint8_t generation;
+  uint8_t windows;
+  uint16_t head_seq;
+  uint32_t saved_at;
+  uint16_t crc;
+};
+
+#define SNAPSHOT_END (SNAPSHOT_START + SNAPSHOT_SLOTS * sizeof(struct snapshot))
+
+bool snapshot_read(struct snapshot* snapshot);
+
+uint16_t snapshot_write(struct snapshot* snapshot);
+
+#endif
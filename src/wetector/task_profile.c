@@ -0,0 +1,125 @@
+
+#include <inttypes.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include "clock.h"
+#include "print.h"
+#include "task_profile.h"
+#include "wetector/pgm_strings.h"
+
+// Runs are timed with the free-running Timer0 counter, which wraps
+// every 256 ticks (about 1 ms). A run that spans a millisecond tick is
+// timed in whole ms instead.
+#define PROFILE_TIMER_COUNT TCNT0
+#define PROFILE_TIMER_CLOCK_SELECT (TCCR0B & (_BV(CS02) | _BV(CS01) | _BV(CS00)))
+
+static struct task_profile* profiles;
+
+// Timer prescaler as a shift, indexed by the CSn2:0 clock select bits
+static const uint8_t timer_prescale_shifts[] = { 0, 0, 3, 6, 8, 10, 0, 0 };
+
+static void profiled_task(struct task* task);
+static uint16_t tick_us(void);
+
+uint8_t task_profile_add_task(struct task_profile* profile, struct task_config* config, task_func func, void* data) {
+  if (profile->name == NULL) {
+    profile->name = config->name;
+    profile->next = profiles;
+    profiles = profile;
+  }
+  profile->func = func;
+  profile->data = data;
+  profile->interval = config->interval;
+  profile->times = config->times;
+  profile->due = clock_get_millis() + config->interval;
+  uint8_t id = scheduler_add_task(config, profiled_task, profile);
+  profile->active = id != TASK_NO_TASK;
+  return id;
+}
+
+void task_profile_remove_task(struct task_profile* profile, uint8_t id) {
+  scheduler_remove_task(id);
+  profile->active = false;
+}
+
+// Dues are compared as differences from now, so they can wrap
+bool task_profile_next_due(uint32_t* due) {
+  uint32_t now = clock_get_millis();
+  bool found = false;
+  for (struct task_profile* profile = profiles; profile != NULL; profile = profile->next) {
+    if (profile->active && (!found || (int32_t) (profile->due - now) < (int32_t) (*due - now))) {
+      *due = profile->due;
+      found = true;
+    }
+  }
+  return found;
+}
+
+void task_profile_print(FILE* stream) {
+  print_format_P(stream, WT_PGM_WETECTOR_SHELL_PROFILE_HEADER, tick_us());
+  for (struct task_profile* profile = profiles; profile != NULL; profile = profile->next) {
+    uint16_t mean_late = profile->runs ? profile->total_late / profile->runs : 0;
+    print_format_P(stream, WT_PGM_WETECTOR_SHELL_PROFILE_ROW, profile->name, profile->runs,
+      profile->total_ticks, profile->max_ticks, mean_late, profile->max_late);
+  }
+  fputc('\n', stream);
+}
+
+void task_profile_reset(void) {
+  for (struct task_profile* profile = profiles; profile != NULL; profile = profile->next) {
+    profile->runs = 0;
+    profile->max_ticks = 0;
+    profile->total_ticks = 0;
+    profile->max_late = 0;
+    profile->total_late = 0;
+  }
+}
+
+static void profiled_task(struct task* task) {
+  struct task_profile* profile = (struct task_profile*) task->data;
+
+  uint32_t start_ms;
+  uint8_t start_ticks;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    start_ms = clock_get_millis();
+    start_ticks = PROFILE_TIMER_COUNT;
+  }
+  int32_t late = (int32_t) (start_ms - profile->due);
+  profile->due = start_ms + profile->interval;
+  // Cleared before the run, which may add the task again
+  if (profile->times != TASK_FOREVER && task->times_run >= profile->times) {
+    profile->active = false;
+  }
+
+  struct task profiled = *task;
+  profiled.data = profile->data;
+  profile->func(&profiled);
+
+  uint32_t end_ms;
+  uint8_t end_ticks;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    end_ms = clock_get_millis();
+    end_ticks = PROFILE_TIMER_COUNT;
+  }
+  uint32_t ticks = (uint8_t) (end_ticks - start_ticks);
+  if (end_ms != start_ms) {
+    ticks = ((end_ms - start_ms) * (F_CPU / 1000UL)) >> timer_prescale_shifts[PROFILE_TIMER_CLOCK_SELECT];
+  }
+
+  profile->runs++;
+  profile->total_ticks += ticks;
+  if (ticks > profile->max_ticks) {
+    profile->max_ticks = ticks > UINT16_MAX ? UINT16_MAX : ticks;
+  }
+  if (late > 0) {
+    profile->total_late += late;
+    if (late > profile->max_late) {
+      profile->max_late = late > UINT16_MAX ? UINT16_MAX : late;
+    }
+  }
+}
+
+static uint16_t tick_us(void) {
+  return (1UL << timer_prescale_shifts[PROFILE_TIMER_CLOCK_SELECT]) / (F_CPU / 1000000UL);
+}
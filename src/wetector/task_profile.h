@@ -0,0 +1,46 @@
+#ifndef TASK_PROFILE_H
+#define TASK_PROFILE_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "common.h"
+#include "scheduler.h"
+
+// Run count, execution time and lateness of one scheduler task.
+// Execution time is in Timer0 ticks, whose length task_profile_print
+// shows; lateness is in ms past the time the task was due. A profile
+// is active while its task is scheduled, which gives the power module
+// the next deadline.
+struct task_profile {
+  const char* name;
+  task_func func;
+  void* data;
+  uint16_t interval;
+  uint16_t times;
+  bool active;
+  uint32_t due;
+  uint32_t runs;
+  uint16_t max_ticks;
+  uint32_t total_ticks;
+  uint16_t max_late;
+  uint32_t total_late;
+  struct task_profile* next;
+};
+
+// Adds the task through a wrapper that times each run into profile.
+// The profile is owned by the caller and registered on first use;
+// func sees data in task->data as usual.
+uint8_t task_profile_add_task(struct task_profile* profile, struct task_config* config, task_func func, void* data);
+
+// Removes a task added with task_profile_add_task
+void task_profile_remove_task(struct task_profile* profile, uint8_t id);
+
+// When the next profiled task is due; false if none is scheduled
+bool task_profile_next_due(uint32_t* due);
+
+void task_profile_print(FILE* stream);
+
+void task_profile_reset(void);
+
+#endif
@@ -0,0 +1,93 @@
+#include <inttypes.h>
+#include <util/crc16.h>
+
+#include "telemetry.h"
+
+// type, seq, payload and crc; short enough that every COBS block fits
+// one code byte
+#define TELEMETRY_MAX_PACKET (2 + TELEMETRY_MAX_PAYLOAD + 2)
+#define SAMPLES_HEADER 5
+#define BUCKETS_HEADER 6
+
+static uint8_t packet[TELEMETRY_MAX_PACKET];
+static uint8_t length;
+static uint8_t seq;
+
+static void write_frame(FILE* stream);
+
+void telemetry_begin(uint8_t type) {
+  packet[0] = type;
+  packet[1] = seq++;
+  length = 2;
+}
+
+void telemetry_put(uint8_t byte) {
+  if (length < TELEMETRY_MAX_PACKET - 2) {
+    packet[length++] = byte;
+  }
+}
+
+void telemetry_put_word(uint16_t word) {
+  telemetry_put(word);
+  telemetry_put(word >> 8);
+}
+
+void telemetry_end(FILE* stream) {
+  uint16_t crc = TELEMETRY_CRC_SEED;
+  for (uint8_t i = 0; i < length; i++) {
+    crc = _crc_ccitt_update(crc, packet[i]);
+  }
+  packet[length++] = crc;
+  packet[length++] = crc >> 8;
+  write_frame(stream);
+}
+
+void telemetry_send_sample_buffer(uint8_t id, const struct sample_buffer* buffer, FILE* stream) {
+  uint16_t real_pos = buffer->start;
+  uint16_t i = 0;
+  do {
+    telemetry_begin(TELEMETRY_TYPE_SAMPLES);
+    telemetry_put(id);
+    telemetry_put_word(i);
+    telemetry_put_word(buffer->count);
+    for (uint8_t n = 0; n < TELEMETRY_MAX_PAYLOAD - SAMPLES_HEADER && i < buffer->count; n++, i++) {
+      telemetry_put(sample_valid_at(buffer, real_pos) ? buffer->samples[real_pos] : TELEMETRY_INVALID_SAMPLE);
+      if (++real_pos == buffer->size) real_pos = 0;
+    }
+    telemetry_end(stream);
+  } while (i < buffer->count);
+}
+
+void telemetry_send_bucket_buffer(uint8_t id, const struct bucket_buffer* buffer, FILE* stream) {
+  uint8_t i = 0;
+  do {
+    telemetry_begin(TELEMETRY_TYPE_BUCKETS);
+    telemetry_put(id);
+    telemetry_put(buffer->window);
+    telemetry_put_word(i);
+    telemetry_put_word(buffer->count);
+    for (uint8_t n = 0; n < (TELEMETRY_MAX_PAYLOAD - BUCKETS_HEADER) / 2 && i < buffer->count; n++, i++) {
+      telemetry_put_word(bucket_at(buffer, i));
+    }
+    telemetry_end(stream);
+  } while (i < buffer->count);
+}
+
+// COBS: each run of non-zero bytes goes out behind a code byte of its
+// length plus one, which stands in for the zero that ends the run
+static void write_frame(FILE* stream) {
+  fputc(0, stream);
+  uint8_t block = 0;
+  while (block <= length) {
+    uint8_t end = block;
+    while (end < length && packet[end] != 0) {
+      end++;
+    }
+    fputc(end - block + 1, stream);
+    for (uint8_t i = block; i < end; i++) {
+      fputc(packet[i], stream);
+    }
+    block = end + 1;
+  }
+  fputc(0, stream);
+}
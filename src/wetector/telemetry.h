@@ -0,0 +1,64 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "common.h"
+#include "sample_buffer.h"
+
+// Binary alternative to the shell's text output. A packet is
+//
+//   type, seq, payload..., crc16 (little endian)
+//
+// COBS encoded and written between two 0x00 delimiters, so a reader
+// can pick frames out of a stream that also carries shell text. seq
+// counts packets, to spot drops; the CRC is _crc_ccitt_update from
+// 0xFFFF over type, seq and payload. Multi-byte fields are little
+// endian. src/decode/decode.c turns frames back into text.
+#define TELEMETRY_MAX_PAYLOAD 56
+#define TELEMETRY_CRC_SEED 0xFFFF
+
+// A sample that failed to read, in TELEMETRY_TYPE_SAMPLES
+#define TELEMETRY_INVALID_SAMPLE 0xFF
+
+enum telemetry_type {
+  // sensor, then humidity 20 s, humidity 10 m, temperature 20 s,
+  // temperature 10 m: the hum_temp_stats means, uint16 with
+  // HUM_TEMP_FRACTION_BITS
+  TELEMETRY_TYPE_STATS = 1,
+  // result, bits, pulse min, pulse max, threshold (uint16 us), then
+  // the uint16 count of each DHT11_RESULT_*
+  TELEMETRY_TYPE_DIAGNOSTICS,
+  // buffer, uint16 offset, uint16 count of the whole buffer, then one
+  // sample per byte, oldest first
+  TELEMETRY_TYPE_SAMPLES,
+  // buffer, window, uint16 offset, uint16 count, then uint16 window
+  // sums, oldest first
+  TELEMETRY_TYPE_BUCKETS
+};
+
+enum telemetry_buffer {
+  TELEMETRY_HUMIDITY_20_SEC, TELEMETRY_HUMIDITY_10_MIN,
+  TELEMETRY_TEMPERATURE_20_SEC, TELEMETRY_TEMPERATURE_10_MIN,
+  TELEMETRY_BUFFER_KINDS
+};
+
+// The buffer byte of SAMPLES and BUCKETS: the sensor and which of its
+// buffers
+#define TELEMETRY_BUFFER_ID(SENSOR, BUFFER) ((SENSOR) * TELEMETRY_BUFFER_KINDS + (BUFFER))
+
+void telemetry_begin(uint8_t type);
+
+void telemetry_put(uint8_t byte);
+
+void telemetry_put_word(uint16_t word);
+
+void telemetry_end(FILE* stream);
+
+// Sends the buffer as as many packets as its samples need
+void telemetry_send_sample_buffer(uint8_t id, const struct sample_buffer* buffer, FILE* stream);
+
+void telemetry_send_bucket_buffer(uint8_t id, const struct bucket_buffer* buffer, FILE* stream);
+
+#endif
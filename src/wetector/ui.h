@@ -5,14 +5,7 @@
 
 #include "common.h"
 #include "event/gpio_event.h"
-
-enum led_state {
-  LED_OFF, LED_ON
-};
-
-enum led_colour {
-  OFF, RED, GREEN, YELLOW, BLUE
-};
+#include "led.h"
 
 void ui_init(void);
 
@@ -20,8 +13,15 @@ void ui_set_power_on(void);
 
 void ui_set_status(uint8_t colour, bool blink);
 
+// Plays an LED_PATTERN_* from led.h, with colour in the steps that
+// don't name their own
+void ui_set_status_pattern(uint8_t colour, uint8_t pattern);
+
 void ui_set_alarm_on(void);
 
+// Plays an ALARM_PATTERN_* from alarm.h, replacing the one playing
+void ui_set_alarm_pattern(uint8_t pattern);
+
 void ui_set_alarm_off(void);
 
 #endif
@@ -1,10 +1,15 @@
 
 #include <inttypes.h>
+#include <stdlib.h>
 
 #include "common.h"
 #include "hum_temp.h"
 #include "log.h"
+#include "power.h"
+#include "print.h"
+#include "rollup_log.h"
 #include "shell.h"
+#include "task_profile.h"
 #include "ui.h"
 
 static void calibrate(void);
@@ -12,15 +17,26 @@ static void start(void);
 static void stop(void);
 
 static bool on_calibrate(event_t* event);
+static bool on_stale(event_t* event);
 static bool on_hum_temp_change(event_t* event);
+static bool on_save(event_t* event);
 
 static shell_result_t shell_handler(shell_command_t* command);
+static bool parse_uint8(const char* arg, uint8_t* value);
+
+// With binary output on, av, dmp and dg answer in telemetry packets
+static bool binary_output;
 
 void setup_task(struct task* task) {
   shell_register_handler("ht", shell_handler);
   hum_temp_init();
   ui_init();  
-  calibrate();
+  power_init();
+  if (hum_temp_warm_start(on_stale)) {
+    start();
+  } else {
+    calibrate();
+  }
 }
 
 static void calibrate() {
@@ -33,6 +49,12 @@ static bool on_calibrate(event_t* event) {
   return false;
 }
 
+static bool on_stale(event_t* event) {
+  stop();
+  calibrate();
+  return false;
+}
+
 static void start() {
   hum_temp_start_collector();
   hum_temp_start_monitor(on_hum_temp_change);
@@ -51,6 +73,12 @@ static bool on_hum_temp_change(event_t* event) {
   return false;
 }
 
+static bool on_save(event_t* event) {
+  struct hum_temp_save_event* save_event = (struct hum_temp_save_event*) event;
+  print_format_P(shell_get_stream(), PSTR("%u ->\n"), save_event->bytes_written);
+  return false;
+}
+
 static shell_result_t shell_handler(shell_command_t* command) {
 	if (command->args_count == 0) return SHELL_RESULT_FAIL;
 	
@@ -60,17 +88,71 @@ static shell_result_t shell_handler(shell_command_t* command) {
 		} else if (string_eq(command->args[0], "stop")) {
       stop();
 		} else if (string_eq(command->args[0], "sv")) {
-      uint16_t bytes_written = hum_temp_save();
-      shell_printf("%u ->\n", bytes_written);
+      uint8_t windows_pending = hum_temp_save(on_save);
+      print_format_P(shell_get_stream(), PSTR("%u ..\n"), windows_pending);
 		} else if (string_eq(command->args[0], "ld")) {
       uint16_t bytes_read = hum_temp_load();
-      shell_printf("%u <-\n", bytes_read);
+      print_format_P(shell_get_stream(), PSTR("%u <-\n"), bytes_read);
 		} else if (string_eq(command->args[0], "av")) {
-      hum_temp_print_stats(shell_get_stream());
+      if (binary_output) {
+        hum_temp_send_stats(shell_get_stream());
+      } else {
+        hum_temp_print_stats(shell_get_stream());
+      }
 		} else if (string_eq(command->args[0], "dmp")) {
-      hum_temp_print_samples(shell_get_stream());
+      uint8_t sensor = command->args_count > 1 ? atoi(command->args[1]) : 0;
+      if (binary_output) {
+        hum_temp_send_samples(shell_get_stream());
+      } else if (!hum_temp_print_samples(sensor, shell_get_stream())) {
+        return SHELL_RESULT_FAIL;
+      }
+		} else if (string_eq(command->args[0], "hr") || string_eq(command->args[0], "dy")) {
+      uint8_t kind = string_eq(command->args[0], "dy") ? ROLLUP_LOG_DAYS : ROLLUP_LOG_HOURS;
+      uint8_t page = command->args_count > 1 ? atoi(command->args[1]) : 0;
+      if (!hum_temp_print_rollups(kind, page, shell_get_stream())) {
+        return SHELL_RESULT_FAIL;
+      }
+		} else if (string_eq(command->args[0], "dg")) {
+      if (command->args_count > 1 && string_eq(command->args[1], "rs")) {
+        hum_temp_reset_diagnostics();
+      } else if (binary_output) {
+        hum_temp_send_diagnostics(shell_get_stream());
+      } else {
+        hum_temp_print_diagnostics(shell_get_stream());
+      }
+		} else if (string_eq(command->args[0], "th")) {
+      uint8_t threshold;
+      uint8_t hysteresis;
+      if (command->args_count < 3
+          || !parse_uint8(command->args[1], &threshold)
+          || !parse_uint8(command->args[2], &hysteresis)
+          || !hum_temp_set_change_threshold(threshold, hysteresis)) {
+        return SHELL_RESULT_FAIL;
+      }
+		} else if (string_eq(command->args[0], "bin")) {
+      if (command->args_count < 2) return SHELL_RESULT_FAIL;
+      binary_output = atoi(command->args[1]) != 0;
+		} else if (string_eq(command->args[0], "prof")) {
+      if (command->args_count > 1 && string_eq(command->args[1], "rs")) {
+        task_profile_reset();
+      } else {
+        task_profile_print(shell_get_stream());
+      }
+		} else if (string_eq(command->args[0], "pw")) {
+      if (command->args_count > 1 && string_eq(command->args[1], "rs")) {
+        power_reset_stats();
+      } else {
+        power_print_stats(shell_get_stream());
+      }
+		} else if (string_eq(command->args[0], "led")) {
+      if (command->args_count < 3) return SHELL_RESULT_FAIL;
+      ui_set_status_pattern(atoi(command->args[1]), atoi(command->args[2]));
 		} else if (string_eq(command->args[0], "al")) {
-      ui_set_alarm_on();
+      if (command->args_count > 1) {
+        ui_set_alarm_pattern(atoi(command->args[1]));
+      } else {
+        ui_set_alarm_on();
+      }
 		} else {
 			return SHELL_RESULT_FAIL;
 		}
@@ -78,3 +160,12 @@ static shell_result_t shell_handler(shell_command_t* command) {
 	return SHELL_RESULT_SUCCESS;
 }
 
+// Whole decimal numbers up to 255 only, where atoi would read "x" as 0
+// and truncate "300"
+static bool parse_uint8(const char* arg, uint8_t* value) {
+  char* end;
+  unsigned long parsed = strtoul(arg, &end, 10);
+  if (end == arg || *end != '\0' || parsed > UINT8_MAX) return false;
+  *value = parsed;
+  return true;
+}